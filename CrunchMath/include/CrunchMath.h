@@ -6,13 +6,15 @@
 #include "../src/Math/Quaternion.h"
 #include "../src/Math/Mat3x3.h"
 #include "../src/Math/Mat4x4.h"
+#include "../src/Math/BatchTransform.h"
 #include "../src/Math/AABB.h"
 #include "../src/Math/OBB.h"
 #include "../src/Math/Sphere.h"
 #include "../src/Math/GeometricUtility.h"
 
 //-----Independent Physics System----
-#include "../src/Physics/body.h"
+#include "../src/Physics/Body.h"
 #include "../src/Physics/Collisions.h"
 #include "../src/Physics/Contacts.h"
+#include "../src/Physics/BroadPhase.h"
 #include "../src/Physics/World.h"
\ No newline at end of file
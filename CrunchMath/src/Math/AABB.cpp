@@ -73,7 +73,7 @@ namespace CrunchMath {
             return ClosestPointOnAABBToPoint;
     }
 
-    bool AABB::BroadPhaseCollisionTest(const AABB& Box)
+    bool AABB::BroadPhaseCollisionTest(const AABB& Box) const
     {
         for (int i = 0; i < 3; i++)
         {
@@ -132,6 +132,35 @@ namespace CrunchMath {
         this->Max[2] = Max.z;
     }
 
+    bool AABB::Contains(const AABB& Box) const
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            if (Box.Min[i] < this->Min[i] || Box.Max[i] > this->Max[i])
+                return false;
+        }
+
+        return true;
+    }
+
+    float AABB::GetSurfaceArea() const
+    {
+        float dx = Max[0] - Min[0];
+        float dy = Max[1] - Min[1];
+        float dz = Max[2] - Min[2];
+
+        return 2.0f * ((dx * dy) + (dy * dz) + (dz * dx));
+    }
+
+    void AABB::Enlarge(float margin)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            this->Min[i] -= margin;
+            this->Max[i] += margin;
+        }
+    }
+
    /* void AABB::TransformBox(const Quaternion& Rotation, const Vec3& Position, Vec3 Size)
     {
         Mat4x4 newBoxModel(1.0f);
@@ -19,14 +19,34 @@ namespace CrunchMath{
 
 		Vec3 ClosestPointAABBPt(const Vec3& Point) const;
 
-		bool BroadPhaseCollisionTest(const AABB& Object2);
+		bool BroadPhaseCollisionTest(const AABB& Object2) const;
 
 		//Narrow Phase Collision shouldn't be ever used for an AABB
 		bool NarrowPhaseCollisionTest(const AABB& Object2);
 
 		void Set(const Vec3& Min, const Vec3& Max);
 
+		//Returns true if Box lies completely inside this AABB
+		bool Contains(const AABB& Box) const;
+
+		float GetSurfaceArea() const;
+
+		//Grows the box by margin on every side
+		void Enlarge(float margin);
+
 		//Note: TO DO >>>
 		//void TransformBox(const Quaternion& Rotation, const Vec3& Position, Vec3 Size);
 	};
+
+	static inline AABB Combine(const AABB& A, const AABB& B)
+	{
+		AABB Box;
+		for (int i = 0; i < 3; i++)
+		{
+			Box.Min[i] = (A.Min[i] < B.Min[i]) ? A.Min[i] : B.Min[i];
+			Box.Max[i] = (A.Max[i] > B.Max[i]) ? A.Max[i] : B.Max[i];
+		}
+
+		return Box;
+	}
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #pragma once
+#include <vector>
 
 namespace CrunchMath {
 	
@@ -16,12 +17,415 @@ namespace CrunchMath {
 		BVHNode* Children[2];
 
 		//Holds the volume of this node enclosing its children if any
-		BV_t* Volume;
+		BV_t Volume;
 
 		//Holds the actual object of this node if its a leaf node
 		obj_t* Object;
 
 		//Holds the node immediately above us in a tree, if present(Parent node to this node)
 		BVHNode* Parent;
+
+		//Holds the height of the subtree below this node, leaves are at height 0
+		int Height;
+
+		bool IsLeaf() const
+		{
+			return Children[0] == nullptr;
+		}
+	};
+
+	/* Incremental bounding volume hierarchy built out of BVHNodes. Objects are only ever stored in
+	 * the leaves, and every node encloses the volumes of its two children. Insertion picks the
+	 * sibling using the surface area heuristic and the tree is kept balanced with rotations on
+	 * the way back up, so a query only visits O(log n) nodes.
+	 *
+	 * Leaves are normally given an enlarged("fat") volume by the caller, see Update(). That way
+	 * an object that only moves a little each frame doesn't touch the tree at all.
+	 *
+	 * BV_t must provide: BroadPhaseCollisionTest(const BV_t&) const, Contains(const BV_t&) const,
+	 * GetSurfaceArea() const, and a free function Combine(const BV_t&, const BV_t&).
+	 */
+	template <class BV_t, class obj_t>
+	class BVHTree
+	{
+	public:
+		typedef BVHNode<BV_t, obj_t> Node;
+
+		BVHTree()
+			:Root(nullptr), FreeList(nullptr), LeafCount(0) {}
+
+		~BVHTree()
+		{
+			for (unsigned i = 0; i < Blocks.size(); i++)
+				delete[] Blocks[i];
+		}
+
+		BVHTree(const BVHTree&) = delete;
+		BVHTree& operator=(const BVHTree&) = delete;
+
+		//Creates a leaf holding the object with the given volume, the returned node is the handle for Update/Remove.
+		Node* Insert(obj_t* object, const BV_t& volume)
+		{
+			Node* leaf = AllocateNode();
+			leaf->Object = object;
+			leaf->Volume = volume;
+			leaf->Height = 0;
+
+			InsertLeaf(leaf);
+			LeafCount++;
+			return leaf;
+		}
+
+		void Remove(Node* leaf)
+		{
+			RemoveLeaf(leaf);
+			FreeNode(leaf);
+			LeafCount--;
+		}
+
+		/* Moves a leaf only if its stored volume no longer contains the object's current volume.
+		 * The leaf is then reinserted with fatVolume. Returns true if the tree was modified.
+		 */
+		bool Update(Node* leaf, const BV_t& volume, const BV_t& fatVolume)
+		{
+			if (leaf->Volume.Contains(volume))
+				return false;
+
+			RemoveLeaf(leaf);
+			leaf->Volume = fatVolume;
+			InsertLeaf(leaf);
+			return true;
+		}
+
+		//Appends every pair of leaves whose volumes overlap, each pair is reported only once.
+		//Any container of PotentialContacts with a push_back will do.
+		template<typename container_t>
+		void GetPotentialContacts(container_t& Contacts) const
+		{
+			if (Root != nullptr)
+				SelfCollide(Root, Contacts);
+		}
+
+		//Calls visit(object) for the object of every leaf whose volume overlaps the given one.
+		template<typename visitor_t>
+		void Query(const BV_t& volume, visitor_t visit) const
+		{
+			if (Root != nullptr)
+				Query(Root, volume, visit);
+		}
+
+		unsigned GetLeafCount() const
+		{
+			return LeafCount;
+		}
+
+		int GetHeight() const
+		{
+			return (Root == nullptr) ? 0 : Root->Height;
+		}
+
+	private:
+		//Nodes are handed out of blocks of this size, so building the tree doesn't allocate per node.
+		const static unsigned NodesPerBlock = 256;
+
+		Node* AllocateNode()
+		{
+			if (FreeList == nullptr)
+			{
+				Node* Block = new Node[NodesPerBlock];
+				Blocks.push_back(Block);
+
+				for (unsigned i = 0; i < NodesPerBlock; i++)
+					FreeNode(Block + i);
+			}
+
+			Node* node = FreeList;
+			FreeList = node->Parent;
+
+			node->Children[0] = nullptr;
+			node->Children[1] = nullptr;
+			node->Object = nullptr;
+			node->Parent = nullptr;
+			node->Height = 0;
+			return node;
+		}
+
+		void FreeNode(Node* node)
+		{
+			//Free nodes are chained through their Parent pointer
+			node->Parent = FreeList;
+			node->Height = -1;
+			FreeList = node;
+		}
+
+		void InsertLeaf(Node* leaf)
+		{
+			if (Root == nullptr)
+			{
+				Root = leaf;
+				Root->Parent = nullptr;
+				return;
+			}
+
+			//Find the best sibling for the new leaf by descending along the cheapest branch
+			Node* Sibling = Root;
+			while (!Sibling->IsLeaf())
+			{
+				float Area = Sibling->Volume.GetSurfaceArea();
+				float CombinedArea = Combine(Sibling->Volume, leaf->Volume).GetSurfaceArea();
+
+				//Cost of creating a new parent for this node and the new leaf
+				float Cost = 2.0f * CombinedArea;
+
+				//Minimum cost of pushing the leaf further down the tree
+				float InheritanceCost = 2.0f * (CombinedArea - Area);
+
+				float ChildCost[2];
+				for (int i = 0; i < 2; i++)
+				{
+					const Node* Child = Sibling->Children[i];
+					ChildCost[i] = Combine(leaf->Volume, Child->Volume).GetSurfaceArea() + InheritanceCost;
+
+					if (!Child->IsLeaf())
+						ChildCost[i] -= Child->Volume.GetSurfaceArea();
+				}
+
+				if (Cost < ChildCost[0] && Cost < ChildCost[1])
+					break;
+
+				Sibling = (ChildCost[0] < ChildCost[1]) ? Sibling->Children[0] : Sibling->Children[1];
+			}
+
+			//Create a new parent holding both the sibling and the leaf
+			Node* OldParent = Sibling->Parent;
+			Node* NewParent = AllocateNode();
+			NewParent->Parent = OldParent;
+			NewParent->Volume = Combine(leaf->Volume, Sibling->Volume);
+			NewParent->Height = Sibling->Height + 1;
+			NewParent->Children[0] = Sibling;
+			NewParent->Children[1] = leaf;
+			Sibling->Parent = NewParent;
+			leaf->Parent = NewParent;
+
+			if (OldParent != nullptr)
+			{
+				if (OldParent->Children[0] == Sibling)
+					OldParent->Children[0] = NewParent;
+				else
+					OldParent->Children[1] = NewParent;
+			}
+
+			else
+				Root = NewParent;
+
+			//Walk back up the tree fixing heights and volumes
+			Refit(leaf->Parent);
+		}
+
+		void RemoveLeaf(Node* leaf)
+		{
+			if (leaf == Root)
+			{
+				Root = nullptr;
+				return;
+			}
+
+			Node* Parent = leaf->Parent;
+			Node* GrandParent = Parent->Parent;
+			Node* Sibling = (Parent->Children[0] == leaf) ? Parent->Children[1] : Parent->Children[0];
+
+			if (GrandParent != nullptr)
+			{
+				//Destroy the parent and connect the sibling to the grand parent
+				if (GrandParent->Children[0] == Parent)
+					GrandParent->Children[0] = Sibling;
+				else
+					GrandParent->Children[1] = Sibling;
+
+				Sibling->Parent = GrandParent;
+				FreeNode(Parent);
+
+				Refit(GrandParent);
+			}
+
+			else
+			{
+				Root = Sibling;
+				Sibling->Parent = nullptr;
+				FreeNode(Parent);
+			}
+
+			leaf->Parent = nullptr;
+		}
+
+		void Refit(Node* node)
+		{
+			while (node != nullptr)
+			{
+				node = Balance(node);
+				FixNode(node);
+				node = node->Parent;
+			}
+		}
+
+		/* Performs a left or right rotation if node A is imbalanced, and returns the node that
+		 * now sits at A's position in the tree.
+		 */
+		Node* Balance(Node* A)
+		{
+			if (A->IsLeaf() || A->Height < 2)
+				return A;
+
+			Node* B = A->Children[0];
+			Node* C = A->Children[1];
+
+			int Skew = C->Height - B->Height;
+
+			//Rotate C up
+			if (Skew > 1)
+			{
+				Node* F = C->Children[0];
+				Node* G = C->Children[1];
+
+				C->Children[0] = A;
+				C->Parent = A->Parent;
+				A->Parent = C;
+				ReplaceChild(C->Parent, A, C);
+
+				if (F->Height > G->Height)
+				{
+					C->Children[1] = F;
+					A->Children[1] = G;
+					G->Parent = A;
+				}
+
+				else
+				{
+					C->Children[1] = G;
+					A->Children[1] = F;
+					F->Parent = A;
+				}
+
+				FixNode(A);
+				FixNode(C);
+				return C;
+			}
+
+			//Rotate B up
+			if (Skew < -1)
+			{
+				Node* D = B->Children[0];
+				Node* E = B->Children[1];
+
+				B->Children[0] = A;
+				B->Parent = A->Parent;
+				A->Parent = B;
+				ReplaceChild(B->Parent, A, B);
+
+				if (D->Height > E->Height)
+				{
+					B->Children[1] = D;
+					A->Children[0] = E;
+					E->Parent = A;
+				}
+
+				else
+				{
+					B->Children[1] = E;
+					A->Children[0] = D;
+					D->Parent = A;
+				}
+
+				FixNode(A);
+				FixNode(B);
+				return B;
+			}
+
+			return A;
+		}
+
+		void ReplaceChild(Node* parent, Node* oldChild, Node* newChild)
+		{
+			if (parent == nullptr)
+			{
+				Root = newChild;
+				return;
+			}
+
+			if (parent->Children[0] == oldChild)
+				parent->Children[0] = newChild;
+			else
+				parent->Children[1] = newChild;
+		}
+
+		void FixNode(Node* node)
+		{
+			Node* Child1 = node->Children[0];
+			Node* Child2 = node->Children[1];
+
+			node->Height = 1 + ((Child1->Height > Child2->Height) ? Child1->Height : Child2->Height);
+			node->Volume = Combine(Child1->Volume, Child2->Volume);
+		}
+
+		template<typename visitor_t>
+		void Query(const Node* node, const BV_t& volume, visitor_t& visit) const
+		{
+			if (!node->Volume.BroadPhaseCollisionTest(volume))
+				return;
+
+			if (node->IsLeaf())
+			{
+				visit(node->Object);
+				return;
+			}
+
+			Query(node->Children[0], volume, visit);
+			Query(node->Children[1], volume, visit);
+		}
+
+		template<typename container_t>
+		void SelfCollide(const Node* node, container_t& Contacts) const
+		{
+			if (node->IsLeaf())
+				return;
+
+			SelfCollide(node->Children[0], Contacts);
+			SelfCollide(node->Children[1], Contacts);
+			Collide(node->Children[0], node->Children[1], Contacts);
+		}
+
+		template<typename container_t>
+		void Collide(const Node* A, const Node* B, container_t& Contacts) const
+		{
+			if (!A->Volume.BroadPhaseCollisionTest(B->Volume))
+				return;
+
+			if (A->IsLeaf() && B->IsLeaf())
+			{
+				PotentialContact<obj_t> Contact;
+				Contact.Object[0] = A->Object;
+				Contact.Object[1] = B->Object;
+				Contacts.push_back(Contact);
+				return;
+			}
+
+			//Descend into the larger volume first, unless it is a leaf
+			if (B->IsLeaf() || (!A->IsLeaf() && A->Volume.GetSurfaceArea() >= B->Volume.GetSurfaceArea()))
+			{
+				Collide(A->Children[0], B, Contacts);
+				Collide(A->Children[1], B, Contacts);
+			}
+
+			else
+			{
+				Collide(A, B->Children[0], Contacts);
+				Collide(A, B->Children[1], Contacts);
+			}
+		}
+
+		Node* Root;
+		Node* FreeList;
+		std::vector<Node*> Blocks;
+		unsigned LeafCount;
 	};
-}
\ No newline at end of file
+}
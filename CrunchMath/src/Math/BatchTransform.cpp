@@ -0,0 +1,307 @@
+#include "BatchTransform.h"
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace CrunchMath {
+
+	//The columns a batch is transformed by, their fourth lanes zero. Point tells
+	//whether the last column, the translation, is added.
+	struct BatchMatrix
+	{
+		SIMD::Float4 Column[4];
+		bool Point;
+	};
+
+	//The x, y and z arrays of a structure of arrays batch.
+	struct BatchArrays
+	{
+		const float* In[3];
+		float* Out[3];
+	};
+
+	static BatchMatrix FromMat4x4(const Mat4x4& m, bool Point)
+	{
+		BatchMatrix Result;
+		for (int i = 0; i < 4; i++)
+			Result.Column[i] = SIMD::SetW(m.LoadColumn(i), 0.0f);
+
+		Result.Point = Point;
+		return Result;
+	}
+
+	static BatchMatrix FromMat3x3(const Mat3x3& m)
+	{
+		BatchMatrix Result;
+		for (int i = 0; i < 3; i++)
+			Result.Column[i] = m.LoadColumn(i);
+
+		Result.Column[3] = SIMD::Splat(0.0f);
+		Result.Point = false;
+		return Result;
+	}
+
+	static BatchMatrix FromQuaternion(const Quaternion& q)
+	{
+		Mat3x3 m;
+		m.SetRotate(q);
+		return FromMat3x3(m);
+	}
+
+	//Same sums in the same order as operator*(Mat4x4, Vec3).
+	template<bool Point>
+	static inline SIMD::Float4 TransformOne(const BatchMatrix& m, float x, float y, float z)
+	{
+		SIMD::Float4 Result = SIMD::Mul(m.Column[0], SIMD::Splat(x));
+		Result = SIMD::Add(Result, SIMD::Mul(m.Column[1], SIMD::Splat(y)));
+		Result = SIMD::Add(Result, SIMD::Mul(m.Column[2], SIMD::Splat(z)));
+		if (Point)
+			Result = SIMD::Add(Result, m.Column[3]);
+
+		return Result;
+	}
+
+	template<bool Point>
+	static void TransformVec3s(const BatchMatrix& m, const Vec3* In, Vec3* Out, unsigned Begin, unsigned End)
+	{
+		for (unsigned i = Begin; i < End; i++)
+			SIMD::StoreAligned(&Out[i].x, TransformOne<Point>(m, In[i].x, In[i].y, In[i].z));
+	}
+
+	template<bool Point>
+	static void TransformPacked(const BatchMatrix& m, const float* In, float* Out, unsigned Begin, unsigned End)
+	{
+		for (size_t i = Begin; i < End; i++)
+		{
+			const float* p = In + i * 3;
+			SIMD::Store3(Out + i * 3, TransformOne<Point>(m, p[0], p[1], p[2]));
+		}
+	}
+
+	template<bool Aligned>
+	static inline SIMD::Float4 LoadLanes(const float* p)
+	{
+		return Aligned ? SIMD::LoadAligned(p) : SIMD::Load(p);
+	}
+
+	template<bool Aligned>
+	static inline void StoreLanes(float* p, SIMD::Float4 a)
+	{
+		if (Aligned)
+			SIMD::StoreAligned(p, a);
+		else
+			SIMD::Store(p, a);
+	}
+
+	//One output component of four elements, summed as TransformOne sums a lane.
+	template<bool Point>
+	static inline SIMD::Float4 TransformLanes(const SIMD::Float4* Row, SIMD::Float4 x, SIMD::Float4 y, SIMD::Float4 z)
+	{
+		SIMD::Float4 Result = SIMD::Mul(Row[0], x);
+		Result = SIMD::Add(Result, SIMD::Mul(Row[1], y));
+		Result = SIMD::Add(Result, SIMD::Mul(Row[2], z));
+		if (Point)
+			Result = SIMD::Add(Result, Row[3]);
+
+		return Result;
+	}
+
+	template<bool Point, bool Aligned>
+	static void TransformArrays(const BatchMatrix& m, const BatchArrays& Arrays, unsigned Begin, unsigned End)
+	{
+		alignas(16) float Elements[4][4];
+		for (int i = 0; i < 4; i++)
+			SIMD::StoreAligned(Elements[i], m.Column[i]);
+
+		//Row j holds element j of every column, each splat over four lanes.
+		SIMD::Float4 Rows[3][4];
+		for (int j = 0; j < 3; j++)
+			for (int i = 0; i < 4; i++)
+				Rows[j][i] = SIMD::Splat(Elements[i][j]);
+
+		const float* InX = Arrays.In[0];
+		const float* InY = Arrays.In[1];
+		const float* InZ = Arrays.In[2];
+		float* OutX = Arrays.Out[0];
+		float* OutY = Arrays.Out[1];
+		float* OutZ = Arrays.Out[2];
+
+		unsigned i = Begin;
+		for (; i + 4 <= End; i += 4)
+		{
+			SIMD::Float4 x = LoadLanes<Aligned>(InX + i);
+			SIMD::Float4 y = LoadLanes<Aligned>(InY + i);
+			SIMD::Float4 z = LoadLanes<Aligned>(InZ + i);
+
+			SIMD::Float4 ResultX = TransformLanes<Point>(Rows[0], x, y, z);
+			SIMD::Float4 ResultY = TransformLanes<Point>(Rows[1], x, y, z);
+			SIMD::Float4 ResultZ = TransformLanes<Point>(Rows[2], x, y, z);
+
+			StoreLanes<Aligned>(OutX + i, ResultX);
+			StoreLanes<Aligned>(OutY + i, ResultY);
+			StoreLanes<Aligned>(OutZ + i, ResultZ);
+		}
+
+		//The last few go through a zero padded group of four.
+		if (i < End)
+		{
+			alignas(16) float Tail[6][4] = {};
+			for (unsigned k = i; k < End; k++)
+				for (int j = 0; j < 3; j++)
+					Tail[j][k - i] = Arrays.In[j][k];
+
+			BatchArrays Padded = { { Tail[0], Tail[1], Tail[2] }, { Tail[3], Tail[4], Tail[5] } };
+			TransformArrays<Point, true>(m, Padded, 0, 4);
+
+			for (unsigned k = i; k < End; k++)
+				for (int j = 0; j < 3; j++)
+					Arrays.Out[j][k] = Tail[3 + j][k - i];
+		}
+	}
+
+	//Runs work over [0, Count), cut into one range per thread. The ranges start on
+	//multiples of four, so aligned arrays stay aligned in every range.
+	template<typename Work>
+	static void RunBatch(unsigned Count, unsigned ThreadCount, const Work& work)
+	{
+		unsigned Threads = Count / MinItemsPerThread;
+		if (ThreadCount < Threads)
+			Threads = ThreadCount;
+
+		if (Threads <= 1)
+		{
+			work(0u, Count);
+			return;
+		}
+
+		unsigned Range = ((Count + Threads - 1) / Threads + 3) & ~3u;
+
+		std::vector<std::thread> Workers;
+		Workers.reserve(Threads - 1);
+		for (unsigned t = 1; t < Threads && t * Range < Count; t++)
+		{
+			unsigned Begin = t * Range;
+			unsigned End = (Count - Begin > Range) ? Begin + Range : Count;
+			Workers.emplace_back([&work, Begin, End]() { work(Begin, End); });
+		}
+
+		work(0u, Range);
+
+		for (std::thread& Worker : Workers)
+			Worker.join();
+	}
+
+	static void Batch(const BatchMatrix& m, const Vec3* In, Vec3* Out, unsigned Count, unsigned ThreadCount)
+	{
+		RunBatch(Count, ThreadCount, [&](unsigned Begin, unsigned End)
+		{
+			if (m.Point)
+				TransformVec3s<true>(m, In, Out, Begin, End);
+			else
+				TransformVec3s<false>(m, In, Out, Begin, End);
+		});
+	}
+
+	static void Batch(const BatchMatrix& m, const float* In, float* Out, unsigned Count, unsigned ThreadCount)
+	{
+		RunBatch(Count, ThreadCount, [&](unsigned Begin, unsigned End)
+		{
+			if (m.Point)
+				TransformPacked<true>(m, In, Out, Begin, End);
+			else
+				TransformPacked<false>(m, In, Out, Begin, End);
+		});
+	}
+
+	static void Batch(const BatchMatrix& m, const float* InX, const float* InY, const float* InZ,
+		float* OutX, float* OutY, float* OutZ, unsigned Count, unsigned ThreadCount)
+	{
+		BatchArrays Arrays = { { InX, InY, InZ }, { OutX, OutY, OutZ } };
+
+		uintptr_t Addresses = reinterpret_cast<uintptr_t>(InX) | reinterpret_cast<uintptr_t>(InY) | reinterpret_cast<uintptr_t>(InZ)
+			| reinterpret_cast<uintptr_t>(OutX) | reinterpret_cast<uintptr_t>(OutY) | reinterpret_cast<uintptr_t>(OutZ);
+		bool Aligned = (Addresses & 15) == 0;
+
+		RunBatch(Count, ThreadCount, [&](unsigned Begin, unsigned End)
+		{
+			if (m.Point)
+			{
+				if (Aligned)
+					TransformArrays<true, true>(m, Arrays, Begin, End);
+				else
+					TransformArrays<true, false>(m, Arrays, Begin, End);
+			}
+			else
+			{
+				if (Aligned)
+					TransformArrays<false, true>(m, Arrays, Begin, End);
+				else
+					TransformArrays<false, false>(m, Arrays, Begin, End);
+			}
+		});
+	}
+
+	void TransformPoints(const Mat4x4& m, const Vec3* In, Vec3* Out, unsigned Count, unsigned ThreadCount)
+	{
+		Batch(FromMat4x4(m, true), In, Out, Count, ThreadCount);
+	}
+
+	void TransformPoints(const Mat4x4& m, const float* In, float* Out, unsigned Count, unsigned ThreadCount)
+	{
+		Batch(FromMat4x4(m, true), In, Out, Count, ThreadCount);
+	}
+
+	void TransformPoints(const Mat4x4& m, const float* InX, const float* InY, const float* InZ,
+		float* OutX, float* OutY, float* OutZ, unsigned Count, unsigned ThreadCount)
+	{
+		Batch(FromMat4x4(m, true), InX, InY, InZ, OutX, OutY, OutZ, Count, ThreadCount);
+	}
+
+	void TransformDirections(const Mat4x4& m, const Vec3* In, Vec3* Out, unsigned Count, unsigned ThreadCount)
+	{
+		Batch(FromMat4x4(m, false), In, Out, Count, ThreadCount);
+	}
+
+	void TransformDirections(const Mat4x4& m, const float* In, float* Out, unsigned Count, unsigned ThreadCount)
+	{
+		Batch(FromMat4x4(m, false), In, Out, Count, ThreadCount);
+	}
+
+	void TransformDirections(const Mat4x4& m, const float* InX, const float* InY, const float* InZ,
+		float* OutX, float* OutY, float* OutZ, unsigned Count, unsigned ThreadCount)
+	{
+		Batch(FromMat4x4(m, false), InX, InY, InZ, OutX, OutY, OutZ, Count, ThreadCount);
+	}
+
+	void Transform(const Mat3x3& m, const Vec3* In, Vec3* Out, unsigned Count, unsigned ThreadCount)
+	{
+		Batch(FromMat3x3(m), In, Out, Count, ThreadCount);
+	}
+
+	void Transform(const Mat3x3& m, const float* In, float* Out, unsigned Count, unsigned ThreadCount)
+	{
+		Batch(FromMat3x3(m), In, Out, Count, ThreadCount);
+	}
+
+	void Transform(const Mat3x3& m, const float* InX, const float* InY, const float* InZ,
+		float* OutX, float* OutY, float* OutZ, unsigned Count, unsigned ThreadCount)
+	{
+		Batch(FromMat3x3(m), InX, InY, InZ, OutX, OutY, OutZ, Count, ThreadCount);
+	}
+
+	void Rotate(const Quaternion& q, const Vec3* In, Vec3* Out, unsigned Count, unsigned ThreadCount)
+	{
+		Batch(FromQuaternion(q), In, Out, Count, ThreadCount);
+	}
+
+	void Rotate(const Quaternion& q, const float* In, float* Out, unsigned Count, unsigned ThreadCount)
+	{
+		Batch(FromQuaternion(q), In, Out, Count, ThreadCount);
+	}
+
+	void Rotate(const Quaternion& q, const float* InX, const float* InY, const float* InZ,
+		float* OutX, float* OutY, float* OutZ, unsigned Count, unsigned ThreadCount)
+	{
+		Batch(FromQuaternion(q), InX, InY, InZ, OutX, OutY, OutZ, Count, ThreadCount);
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "Vec3.h"
+#include "Quaternion.h"
+#include "Mat3x3.h"
+#include "Mat4x4.h"
+
+//***************************************************************************************
+//Batched transforms, for whole arrays of points or directions at once instead of one
+//operator* per element. Every function comes in three layouts:
+//  - an array of Vec3,
+//  - packed x, y, z floats, three per element with no padding (vertex buffers),
+//  - three separate arrays of x, y and z (a structure of arrays).
+//The matrix is loaded once per call and the elements go through SIMD four lanes at a
+//time. The structure of arrays layout takes the aligned path when all six arrays are
+//16 byte aligned, and the unaligned one otherwise.
+//
+//Each element rounds exactly as operator*(Mat4x4, Vec3) or operator*(Mat3x3, Vec3)
+//would round it. In and Out may be the same array, but must not overlap otherwise.
+//
+//ThreadCount above one splits a large batch over that many threads, the calling thread
+//included. Threads are only started for batches of at least MinItemsPerThread elements
+//per thread, below that the call runs on the caller alone.
+//***************************************************************************************
+
+namespace CrunchMath {
+
+	const unsigned MinItemsPerThread = 65536;
+
+	//Transforms points, the translation of m applies. The last row of m is not used.
+	void TransformPoints(const Mat4x4& m, const Vec3* In, Vec3* Out, unsigned Count, unsigned ThreadCount = 1);
+
+	void TransformPoints(const Mat4x4& m, const float* In, float* Out, unsigned Count, unsigned ThreadCount = 1);
+
+	void TransformPoints(const Mat4x4& m, const float* InX, const float* InY, const float* InZ,
+		float* OutX, float* OutY, float* OutZ, unsigned Count, unsigned ThreadCount = 1);
+
+	//Transforms directions, the translation of m doesn't apply.
+	void TransformDirections(const Mat4x4& m, const Vec3* In, Vec3* Out, unsigned Count, unsigned ThreadCount = 1);
+
+	void TransformDirections(const Mat4x4& m, const float* In, float* Out, unsigned Count, unsigned ThreadCount = 1);
+
+	void TransformDirections(const Mat4x4& m, const float* InX, const float* InY, const float* InZ,
+		float* OutX, float* OutY, float* OutZ, unsigned Count, unsigned ThreadCount = 1);
+
+	void Transform(const Mat3x3& m, const Vec3* In, Vec3* Out, unsigned Count, unsigned ThreadCount = 1);
+
+	void Transform(const Mat3x3& m, const float* In, float* Out, unsigned Count, unsigned ThreadCount = 1);
+
+	void Transform(const Mat3x3& m, const float* InX, const float* InY, const float* InZ,
+		float* OutX, float* OutY, float* OutZ, unsigned Count, unsigned ThreadCount = 1);
+
+	//Rotates by a unit quaternion. The rotation matrix of q is built once and used for the
+	//whole batch, as Mat3x3::SetRotate builds it.
+	void Rotate(const Quaternion& q, const Vec3* In, Vec3* Out, unsigned Count, unsigned ThreadCount = 1);
+
+	void Rotate(const Quaternion& q, const float* In, float* Out, unsigned Count, unsigned ThreadCount = 1);
+
+	void Rotate(const Quaternion& q, const float* InX, const float* InY, const float* InZ,
+		float* OutX, float* OutY, float* OutZ, unsigned Count, unsigned ThreadCount = 1);
+}
@@ -1,4 +1,5 @@
 #include "Mat3x3.h"
+#include <utility>
 
 namespace CrunchMath
 {
@@ -29,17 +30,6 @@ namespace CrunchMath
 		Matrix[0][2] = 0.0f;     Matrix[1][2] = 0.0f;     Matrix[2][2] = 1.0f;
 	}
 
-	Mat3x3::Mat3x3(const Mat3x3& m)
-	{
-		for (int i = 0; i < 3; i++)
-		{
-			for (int j = 0; j < 3; j++)
-			{
-				Matrix[i][j] = m.Matrix[i][j];
-			}
-		}
-	}
-
 	Mat3x3::Mat3x3(const Mat4x4& m)
 	{
 		for (int i = 0; i < 3; i++)
@@ -59,36 +49,14 @@ namespace CrunchMath
 		Matrix[0][2] = 0.0f;       Matrix[1][2] = 0.0f;      Matrix[2][2] = identity;
 	}
 
-	Mat3x3& Mat3x3::operator=(const Mat3x3& rhs)
-	{
-		for (int i = 0; i < 3; i++)
-		{
-			for (int j = 0; j < 3; j++)
-			{
-				Matrix[i][j] = rhs.Matrix[i][j];
-			}
-		}
-		return *this;
-	}
-
-	Mat3x3 Mat3x3::Multiply(const Mat3x3& rhs)
+	Mat3x3 Mat3x3::Multiply(const Mat3x3& rhs) const
 	{
 		Mat3x3 result;
-		float hold = 0.0f;
 
-		for (int h = 0; h < 3; h++)
-		{
-			for (int i = 0; i < 3; i++)
-			{
-				for (int j = 0; j < 3; j++)
-				{
-					hold += (Matrix[j][h] * rhs.Matrix[i][j]);
-				}
+		//Column i of the result is this matrix times column i of rhs.
+		for (int i = 0; i < 3; i++)
+			result.StoreColumn(i, (*this * rhs.GetColumnVector(i)).Load());
 
-				result.Matrix[i][h] = hold;
-				hold = 0.0f;
-			}
-		}
 		return result;
 	}
 
@@ -135,23 +103,14 @@ namespace CrunchMath
 
 	Mat3x3& Mat3x3::Transpose()
 	{
-		*this = Mat3x3(
-
-			Vec3(Matrix[0][0], Matrix[1][0], Matrix[2][0]), //Row Vector Arrangement; (vec1)
-
-			Vec3(Matrix[0][1], Matrix[1][1], Matrix[2][1]),                        // (vec2)
-
-			Vec3(Matrix[0][2], Matrix[1][2], Matrix[2][2])                         // (vec3)
-		);
+		//Three swaps, the 12 byte columns don't make a whole SIMD transpose worth it.
+		std::swap(Matrix[0][1], Matrix[1][0]);
+		std::swap(Matrix[0][2], Matrix[2][0]);
+		std::swap(Matrix[1][2], Matrix[2][1]);
 
 		return *this;
 	}
 
-	Vec3 Mat3x3::GetColumnVector(int i) const
-	{
-		return Vec3(Matrix[i][0], Matrix[i][1], Matrix[i][2]);
-	}
-
 	void Mat3x3::SetRotate(const Quaternion& q)
 	{
 		//column vec 1...
@@ -172,31 +131,30 @@ namespace CrunchMath
 
 	Mat3x3 Invert(const Mat3x3& refm)
 	{
-		Mat3x3 m = refm;
-
-		if (m.RotationMatrix)
+		if (refm.RotationMatrix)
 		{
+			Mat3x3 m = refm;
 			m.Transpose();
 			return m;
 		}
 
-		float det = Determinant(m);
+		//The rows of the adjugate are the cross products of the columns taken in pairs.
+		SIMD::Float4 a = refm.LoadColumn(0), b = refm.LoadColumn(1), c = refm.LoadColumn(2);
+		SIMD::Float4 r0 = SIMD::Cross3(b, c);
+		SIMD::Float4 r1 = SIMD::Cross3(c, a);
+		SIMD::Float4 r2 = SIMD::Cross3(a, b);
+		SIMD::Float4 r3 = SIMD::Splat(0.0f);
+		SIMD::Transpose4(r0, r1, r2, r3);
+
+		//Expanded along the first row, as Determinant does.
+		float det = SIMD::Dot3(SIMD::Set(refm.Matrix[0][0], refm.Matrix[1][0], refm.Matrix[2][0], 0.0f), r0);
 		//assert(det == 0.0f);
-		float oneoverdet = 1.0f / det;
-
-		Mat3x3 Temp = m;
-		//Column Vector 1
-		m.Matrix[0][0] = ((Temp.Matrix[1][1] * Temp.Matrix[2][2]) - (Temp.Matrix[2][1] * Temp.Matrix[1][2])) * oneoverdet;
-		m.Matrix[0][1] = -((Temp.Matrix[0][1] * Temp.Matrix[2][2]) - (Temp.Matrix[2][1] * Temp.Matrix[0][2])) * oneoverdet;
-		m.Matrix[0][2] = ((Temp.Matrix[0][1] * Temp.Matrix[1][2]) - (Temp.Matrix[1][1] * Temp.Matrix[0][2])) * oneoverdet;
-		//Column Vector 2
-		m.Matrix[1][0] = -((Temp.Matrix[1][0] * Temp.Matrix[2][2]) - (Temp.Matrix[2][0] * Temp.Matrix[1][2])) * oneoverdet;
-		m.Matrix[1][1] = ((Temp.Matrix[0][0] * Temp.Matrix[2][2]) - (Temp.Matrix[2][0] * Temp.Matrix[0][2])) * oneoverdet;
-		m.Matrix[1][2] = -((Temp.Matrix[0][0] * Temp.Matrix[1][2]) - (Temp.Matrix[1][0] * Temp.Matrix[0][2])) * oneoverdet;
-		//Column Vector 3
-		m.Matrix[2][0] = ((Temp.Matrix[1][0] * Temp.Matrix[2][1]) - (Temp.Matrix[2][0] * Temp.Matrix[1][1])) * oneoverdet;
-		m.Matrix[2][1] = -((Temp.Matrix[0][0] * Temp.Matrix[2][1]) - (Temp.Matrix[2][0] * Temp.Matrix[0][1])) * oneoverdet;
-		m.Matrix[2][2] = ((Temp.Matrix[0][0] * Temp.Matrix[1][1]) - (Temp.Matrix[1][0] * Temp.Matrix[0][1])) * oneoverdet;
+		SIMD::Float4 oneoverdet = SIMD::Splat(1.0f / det);
+
+		Mat3x3 m;
+		m.StoreColumn(0, SIMD::Mul(r0, oneoverdet));
+		m.StoreColumn(1, SIMD::Mul(r1, oneoverdet));
+		m.StoreColumn(2, SIMD::Mul(r2, oneoverdet));
 
 		return m;
 	}
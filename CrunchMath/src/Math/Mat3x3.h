@@ -17,15 +17,15 @@ namespace CrunchMath{
 
 		Mat3x3(const Vec3& col1, const Vec3& col2);
 
-		Mat3x3(const Mat3x3& m);
+		Mat3x3(const Mat3x3& m) = default;
 
 		Mat3x3(const Mat4x4& m);
 
 		Mat3x3(float identiy);
 
-		Mat3x3& operator=(const Mat3x3& rhs);
+		Mat3x3& operator=(const Mat3x3& rhs) = default;
 
-		Mat3x3 Multiply(const Mat3x3& rhs);
+		Mat3x3 Multiply(const Mat3x3& rhs) const;
 
 		Mat3x3& operator*=(const Mat3x3& rhs);
 
@@ -39,23 +39,39 @@ namespace CrunchMath{
 
 		Mat3x3& Transpose();
 
-		Vec3 GetColumnVector(int i) const;
+		Vec3 GetColumnVector(int i) const
+		{
+			return Vec3(LoadColumn(i));
+		}
+
+		//Loads column i into a SIMD register, its fourth lane zero.
+		SIMD::Float4 LoadColumn(int i) const
+		{
+			return SIMD::Load3(Matrix[i]);
+		}
+
+		//Stores the first three lanes of Column as column i.
+		void StoreColumn(int i, SIMD::Float4 Column)
+		{
+			SIMD::Store3(Matrix[i], Column);
+		}
 
 		void SetRotate(const Quaternion& q);
 	};
 
-	static inline Mat3x3 operator*(Mat3x3& lhs, const Mat3x3& rhs)
+	static inline Mat3x3 operator*(const Mat3x3& lhs, const Mat3x3& rhs)
 	{
 		return lhs.Multiply(rhs);
 	}
 
+	//Sums the scaled columns one after the other, so each component rounds as (m0 * x + m1 * y) + m2 * z.
 	static inline Vec3 operator*(const Mat3x3& lhs, const Vec3& rhs)
 	{
-		return Vec3(
-			          (lhs.Matrix[0][0] * rhs.x) + (lhs.Matrix[1][0] * rhs.y) + (lhs.Matrix[2][0] * rhs.z),
-			          (lhs.Matrix[0][1] * rhs.x) + (lhs.Matrix[1][1] * rhs.y) + (lhs.Matrix[2][1] * rhs.z),
-			          (lhs.Matrix[0][2] * rhs.x) + (lhs.Matrix[1][2] * rhs.y) + (lhs.Matrix[2][2] * rhs.z)
-		           );
+		SIMD::Float4 Result = SIMD::Mul(lhs.LoadColumn(0), SIMD::Splat(rhs.x));
+		Result = SIMD::Add(Result, SIMD::Mul(lhs.LoadColumn(1), SIMD::Splat(rhs.y)));
+		Result = SIMD::Add(Result, SIMD::Mul(lhs.LoadColumn(2), SIMD::Splat(rhs.z)));
+
+		return Vec3(Result);
 	}
 
 	static inline float Determinant(const Mat3x3& m)
@@ -36,29 +36,6 @@ namespace CrunchMath {
 		Matrix[0][3] = 0.0f;     Matrix[1][3] = 0.0f;     Matrix[2][3] = 0.0f;    Matrix[3][3] = 1.0f;
 	}
 
-	Mat4x4::Mat4x4(const Mat4x4& m)
-	{
-		for (int i = 0; i < 4; i++)
-		{
-			for (int j = 0; j < 4; j++)
-			{
-				Matrix[i][j] = m.Matrix[i][j];
-			}
-		}
-	}
-
-	Mat4x4& Mat4x4::operator=(const Mat4x4& rhs)
-	{
-		for (int i = 0; i < 4; i++)
-		{
-			for (int j = 0; j < 4; j++)
-			{
-				Matrix[i][j] = rhs.Matrix[i][j];
-			}
-		}
-		return *this;
-	}
-
 	void Mat4x4::SetToIdentity()
 	{
 		for (int i = 0; i < 4; i++)
@@ -88,23 +65,19 @@ namespace CrunchMath {
 		Matrix[3][0] = Matrix[3][1] = Matrix[3][2] = 0;
 	}
 
-	Mat4x4 Mat4x4::Multiply(const Mat4x4& rhs)
+	Mat4x4 Mat4x4::Multiply(const Mat4x4& rhs) const
 	{
 		Mat4x4 result;
-		float hold = 0.0f;
+		SIMD::Float4 c0 = LoadColumn(0), c1 = LoadColumn(1), c2 = LoadColumn(2), c3 = LoadColumn(3);
 
-		for (int h = 0; h < 4; h++)
+		//Column i of the result is this matrix times column i of rhs, summed in the order of its rows.
+		for (int i = 0; i < 4; i++)
 		{
-			for (int i = 0; i < 4; i++)
-			{
-				for (int j = 0; j < 4; j++)
-				{
-					hold += (Matrix[j][h] * rhs.Matrix[i][j]);
-				}
-				
-				result.Matrix[i][h] = hold;
-				hold = 0.0f;
-			}
+			SIMD::Float4 Column = SIMD::Mul(c0, SIMD::Splat(rhs.Matrix[i][0]));
+			Column = SIMD::Add(Column, SIMD::Mul(c1, SIMD::Splat(rhs.Matrix[i][1])));
+			Column = SIMD::Add(Column, SIMD::Mul(c2, SIMD::Splat(rhs.Matrix[i][2])));
+			Column = SIMD::Add(Column, SIMD::Mul(c3, SIMD::Splat(rhs.Matrix[i][3])));
+			result.StoreColumn(i, Column);
 		}
 		return result;
 	}
@@ -328,16 +301,19 @@ namespace CrunchMath {
 		*this *= Scale;
 	}
 
+	//Transposes the Rotation part only, the Translation is dropped and the last row set to 0, 0, 0, 1.
 	Mat4x4& Mat4x4::Transpose()
 	{	
-		*this = Mat4x4(
+		SIMD::Float4 c0 = SIMD::SetW(LoadColumn(0), 0.0f);
+		SIMD::Float4 c1 = SIMD::SetW(LoadColumn(1), 0.0f);
+		SIMD::Float4 c2 = SIMD::SetW(LoadColumn(2), 0.0f);
+		SIMD::Float4 c3 = SIMD::Set(0.0f, 0.0f, 0.0f, 1.0f);
+		SIMD::Transpose4(c0, c1, c2, c3);
 
-			Vec3(Matrix[0][0], Matrix[1][0], Matrix[2][0]), //Row Vector Arrangement; (vec1)
-
-			Vec3(Matrix[0][1], Matrix[1][1], Matrix[2][1]),                        // (vec2)
-
-			Vec3(Matrix[0][2], Matrix[1][2], Matrix[2][2])                         // (vec3)
-		);
+		StoreColumn(0, c0);
+		StoreColumn(1, c1);
+		StoreColumn(2, c2);
+		StoreColumn(3, c3);
 
 		return *this;
 	}
@@ -348,51 +324,79 @@ namespace CrunchMath {
 		return *this;
 	}
 	
-	Vec3 Mat4x4::GetColumnVector(int i) const
+	//Inverts a matrix with a last row of 0, 0, 0, 1: the inverse of its 3x3 part (see the Mat3x3
+	//Invert), and that inverse applied to the negated Translation.
+	static Mat4x4 InvertAffine(const Mat4x4& m)
 	{
-		return Vec3(Matrix[i][0], Matrix[i][1], Matrix[i][2]);
+		SIMD::Float4 a = m.LoadColumn(0), b = m.LoadColumn(1), c = m.LoadColumn(2);
+		SIMD::Float4 r0 = SIMD::Cross3(b, c);
+		SIMD::Float4 r1 = SIMD::Cross3(c, a);
+		SIMD::Float4 r2 = SIMD::Cross3(a, b);
+		SIMD::Float4 r3 = SIMD::Splat(0.0f);
+		SIMD::Transpose4(r0, r1, r2, r3);
+
+		float det = SIMD::Dot3(SIMD::Set(m.Matrix[0][0], m.Matrix[1][0], m.Matrix[2][0], 0.0f), r0);
+		SIMD::Float4 oneoverdet = SIMD::Splat(1.0f / det);
+
+		Mat4x4 Result;
+		Result.StoreColumn(0, SIMD::SetW(SIMD::Mul(r0, oneoverdet), 0.0f));
+		Result.StoreColumn(1, SIMD::SetW(SIMD::Mul(r1, oneoverdet), 0.0f));
+		Result.StoreColumn(2, SIMD::SetW(SIMD::Mul(r2, oneoverdet), 0.0f));
+		Result.StoreColumn(3, SIMD::Set(0.0f, 0.0f, 0.0f, 1.0f));
+		Result.Translate(-(Result * GetTranslation(m)));
+
+		return Result;
 	}
 
-	Mat4x4 Invert(const Mat4x4& refm)
+	//Inverts any invertible matrix, projections included. With a, b, c, d the first three rows
+	//of the columns and x, y, z, w the last row, the rows of the inverse come out of a few cross
+	//products (Lengyel, Foundations of Game Engine Development, Vol. 1).
+	static Mat4x4 InvertGeneral(const Mat4x4& m)
 	{
-		Mat4x4 m = refm;
+		SIMD::Float4 a = m.LoadColumn(0), b = m.LoadColumn(1), c = m.LoadColumn(2), d = m.LoadColumn(3);
+		float x = m.Matrix[0][3], y = m.Matrix[1][3], z = m.Matrix[2][3], w = m.Matrix[3][3];
+
+		SIMD::Float4 s = SIMD::Cross3(a, b);
+		SIMD::Float4 t = SIMD::Cross3(c, d);
+		SIMD::Float4 u = SIMD::Sub(SIMD::Mul(a, SIMD::Splat(y)), SIMD::Mul(b, SIMD::Splat(x)));
+		SIMD::Float4 v = SIMD::Sub(SIMD::Mul(c, SIMD::Splat(w)), SIMD::Mul(d, SIMD::Splat(z)));
+
+		SIMD::Float4 oneoverdet = SIMD::Splat(1.0f / (SIMD::Dot3(s, v) + SIMD::Dot3(t, u)));
+		s = SIMD::Mul(s, oneoverdet);
+		t = SIMD::Mul(t, oneoverdet);
+		u = SIMD::Mul(u, oneoverdet);
+		v = SIMD::Mul(v, oneoverdet);
+
+		SIMD::Float4 r0 = SIMD::SetW(SIMD::Add(SIMD::Cross3(b, v), SIMD::Mul(t, SIMD::Splat(y))), -SIMD::Dot3(b, t));
+		SIMD::Float4 r1 = SIMD::SetW(SIMD::Sub(SIMD::Cross3(v, a), SIMD::Mul(t, SIMD::Splat(x))), SIMD::Dot3(a, t));
+		SIMD::Float4 r2 = SIMD::SetW(SIMD::Add(SIMD::Cross3(d, u), SIMD::Mul(s, SIMD::Splat(w))), -SIMD::Dot3(d, s));
+		SIMD::Float4 r3 = SIMD::SetW(SIMD::Sub(SIMD::Cross3(u, c), SIMD::Mul(s, SIMD::Splat(z))), SIMD::Dot3(c, s));
+		SIMD::Transpose4(r0, r1, r2, r3);
+
+		Mat4x4 Result;
+		Result.StoreColumn(0, r0);
+		Result.StoreColumn(1, r1);
+		Result.StoreColumn(2, r2);
+		Result.StoreColumn(3, r3);
+
+		return Result;
+	}
 
-		if (m.RotationMatrix)
+	Mat4x4 Invert(const Mat4x4& refm)
+	{
+		if (refm.RotationMatrix)
 		{
-            Vec3 Trans = GetTranslation(m);
+			Mat4x4 m = refm;
+			Vec3 Trans = GetTranslation(m);
 			m.Transpose();
-
-			float x = -((m.Matrix[0][0] * Trans.x) + (m.Matrix[1][0] * Trans.y) + (m.Matrix[2][0] * Trans.z));
-			float y = -((m.Matrix[0][1] * Trans.x) + (m.Matrix[1][1] * Trans.y) + (m.Matrix[2][1] * Trans.z));
-			float z = -((m.Matrix[0][2] * Trans.x) + (m.Matrix[1][2] * Trans.y) + (m.Matrix[2][2] * Trans.z));
-			m.Translate(Vec3(x, y, z));
+			m.Translate(-(m * Trans));
 
 			return m;
 		}
 
-		float det = Determinant(m);
-		float oneoverdet = 1.0f / det;
-
-		   Mat4x4 Temp = m;
-		                                              //Column Vector 1
-		   m.Matrix[0][0] = ((Temp.Matrix[1][1] * Temp.Matrix[2][2]) - (Temp.Matrix[2][1] * Temp.Matrix[1][2])) * oneoverdet;
-		   m.Matrix[0][1] = -((Temp.Matrix[0][1] * Temp.Matrix[2][2]) - (Temp.Matrix[2][1] * Temp.Matrix[0][2])) * oneoverdet;
-		   m.Matrix[0][2] = ((Temp.Matrix[0][1] * Temp.Matrix[1][2]) - (Temp.Matrix[1][1] * Temp.Matrix[0][2])) * oneoverdet;
-		                                               //Column Vector 2
-		   m.Matrix[1][0] = -((Temp.Matrix[1][0] * Temp.Matrix[2][2]) - (Temp.Matrix[2][0] * Temp.Matrix[1][2])) * oneoverdet;
-		   m.Matrix[1][1] = ((Temp.Matrix[0][0] * Temp.Matrix[2][2]) - (Temp.Matrix[2][0] * Temp.Matrix[0][2])) * oneoverdet;
-		   m.Matrix[1][2] = -((Temp.Matrix[0][0] * Temp.Matrix[1][2]) - (Temp.Matrix[1][0] * Temp.Matrix[0][2])) * oneoverdet;
-		                                               //Column Vector 3
-		   m.Matrix[2][0] = ((Temp.Matrix[1][0] * Temp.Matrix[2][1]) - (Temp.Matrix[2][0] * Temp.Matrix[1][1])) * oneoverdet;
-		   m.Matrix[2][1] = -((Temp.Matrix[0][0] * Temp.Matrix[2][1]) - (Temp.Matrix[2][0] * Temp.Matrix[0][1])) * oneoverdet;
-		   m.Matrix[2][2] = ((Temp.Matrix[0][0] * Temp.Matrix[1][1]) - (Temp.Matrix[1][0] * Temp.Matrix[0][1])) * oneoverdet;
-		                                              //Translation Portion
-		   float x = -((m.Matrix[0][0] * m.Matrix[3][0]) + (m.Matrix[1][0] * m.Matrix[3][1]) + (m.Matrix[2][0] * m.Matrix[3][2]));
-		   float y = -((m.Matrix[0][1] * m.Matrix[3][0]) + (m.Matrix[1][1] * m.Matrix[3][1]) + (m.Matrix[2][1] * m.Matrix[3][2]));
-		   float z = -((m.Matrix[0][2] * m.Matrix[3][0]) + (m.Matrix[1][2] * m.Matrix[3][1]) + (m.Matrix[2][2] * m.Matrix[3][2]));
-
-		   m.Translate(Vec3(x, y, z));
-		 
-		return m;
+		if (refm.Matrix[0][3] == 0.0f && refm.Matrix[1][3] == 0.0f && refm.Matrix[2][3] == 0.0f && refm.Matrix[3][3] == 1.0f)
+			return InvertAffine(refm);
+
+		return InvertGeneral(refm);
 	}
 }
\ No newline at end of file
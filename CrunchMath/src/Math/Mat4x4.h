@@ -26,7 +26,7 @@
 
 namespace CrunchMath {
 
-	struct Mat4x4
+	struct alignas(16) Mat4x4
 	{
 		float Matrix[4][4];
 
@@ -36,11 +36,11 @@ namespace CrunchMath {
 
 		Mat4x4(const Vec3& col1, const Vec3& col2, const Vec3& col3);
 
-		Mat4x4(const Mat4x4& m);
+		Mat4x4(const Mat4x4& m) = default;
 
 		Mat4x4(float identiy);
 
-		Mat4x4& operator=(const Mat4x4& rhs);
+		Mat4x4& operator=(const Mat4x4& rhs) = default;
 
 		void SetToIdentity();
 
@@ -48,7 +48,7 @@ namespace CrunchMath {
 
 		void ZeroTranslation();
 
-		Mat4x4 Multiply(const Mat4x4& rhs);
+		Mat4x4 Multiply(const Mat4x4& rhs) const;
 
 		void InsertDiagonal(const float &value);
 
@@ -86,21 +86,38 @@ namespace CrunchMath {
 
 		Mat4x4& operator*=(const Mat4x4& rhs);
 
-		Vec3 GetColumnVector(int i) const;
+		Vec3 GetColumnVector(int i) const
+		{
+			return Vec3(SIMD::SetW(LoadColumn(i), 0.0f));
+		}
+
+		//Loads all four floats of column i into a SIMD register.
+		SIMD::Float4 LoadColumn(int i) const
+		{
+			return SIMD::Load(Matrix[i]);
+		}
+
+		void StoreColumn(int i, SIMD::Float4 Column)
+		{
+			SIMD::Store(Matrix[i], Column);
+		}
     };
 
+	//Transforms the point rhs, each component rounds as ((m0 * x + m1 * y) + m2 * z) + m3.
 	static inline Vec3 operator*(const Mat4x4& lhs, const Vec3& rhs)
 	{
-		return Vec3(  (lhs.Matrix[0][0] * rhs.x) + (lhs.Matrix[1][0] * rhs.y) + (lhs.Matrix[2][0] * rhs.z) + lhs.Matrix[3][0],
-			          (lhs.Matrix[0][1] * rhs.x) + (lhs.Matrix[1][1] * rhs.y) + (lhs.Matrix[2][1] * rhs.z) + lhs.Matrix[3][1],
-			          (lhs.Matrix[0][2] * rhs.x) + (lhs.Matrix[1][2] * rhs.y) + (lhs.Matrix[2][2] * rhs.z) + lhs.Matrix[3][2]
-		           );
+		SIMD::Float4 Result = SIMD::Mul(lhs.LoadColumn(0), SIMD::Splat(rhs.x));
+		Result = SIMD::Add(Result, SIMD::Mul(lhs.LoadColumn(1), SIMD::Splat(rhs.y)));
+		Result = SIMD::Add(Result, SIMD::Mul(lhs.LoadColumn(2), SIMD::Splat(rhs.z)));
+		Result = SIMD::Add(Result, lhs.LoadColumn(3));
+
+		return Vec3(SIMD::SetW(Result, 0.0f));
 	}
 
-	static inline Mat4x4 operator*( Mat4x4& lhs, const Mat4x4& rhs)
+	static inline Mat4x4 operator*(const Mat4x4& lhs, const Mat4x4& rhs)
 	{
-			return lhs.Multiply(rhs);
-    }
+		return lhs.Multiply(rhs);
+	}
 
 	static inline Vec3 GetTranslation(const Mat4x4& m)
 	{
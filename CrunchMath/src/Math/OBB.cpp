@@ -74,9 +74,8 @@ namespace CrunchMath {
 
 		for (int i = 0; i < 3; i++)
 		{
-			int j = 0;
 			//Orientation of the x-axis[0][0 <-to-> 2] , y-axis[1][0 <-to-> 2] and z-axis[2][0 <-to-> 2]
-			Vec3 Orient(OrientationMatrix[i][j++], OrientationMatrix[i][j++], OrientationMatrix[i][j]);
+			Vec3 Orient(OrientationMatrix[i][0], OrientationMatrix[i][1], OrientationMatrix[i][2]);
 
 			//Projecting the point unto each axis with respect to its Orientation
 			float Dist = DotProduct(Orient, d);
@@ -2,34 +2,12 @@
 
 namespace CrunchMath {
 
-	Quaternion::Quaternion()
-		:w(0.0f), x(0.0f), y(0.0f), z(0.0f){}
-
-	Quaternion::Quaternion(float m_w, float m_x, float m_y, float m_z)
-		:w(m_w), x(m_x), y(m_y), z((m_z)){}
-
-	Quaternion::Quaternion(float m_w, Vec3 v)
-		:w(m_w), x(v.x), y(v.y), z(v.z){}
-
-	Quaternion::Quaternion(const Quaternion& Q)
-		:w(Q.w), x(Q.x), y(Q.y), z(Q.z){}
-
 	void Quaternion::SetToIdentity()
 	{
 		w = 1.0f;
 		x = y = z = 0.0f;
 	}
 
-	Quaternion& Quaternion::operator=(const Quaternion& Q)
-	{
-		this->w = Q.w;
-		this->x = Q.x;
-		this->y = Q.y;
-		this->z = Q.z;
-
-		return *this;
-	}
-
 	void Quaternion::SetToRotateAboutX(float radian)
 	{
 		float cos_theta_over2 = cos(radian) * 0.5;
@@ -114,70 +92,209 @@ namespace CrunchMath {
 		z = axis.z * sin_theta_over2;
 	}
 
-	Quaternion Quaternion::operator*(const Quaternion& Q)
+	float Quaternion::GetRotationAngle()
 	{
-		Quaternion result;
-		result.w = w * Q.w - x * Q.x - y * Q.y - z * Q.z;
-		result.x = w * Q.x + x * Q.w + z * Q.y - y * Q.z;
-		result.y = w * Q.y + y * Q.w + x * Q.z - z * Q.x;
-		result.z = w * Q.z + z * Q.w + y * Q.x - x * Q.y;
-
-		return result;
+		return (acos2(w * 2));
 	}
 
-	Quaternion& Quaternion::operator+=(const Quaternion& Q)
+	Vec3 Quaternion::GetRotationAxis()
 	{
-		w += Q.w;
-		x += Q.x;
-		y += Q.y;
-		z += Q.z;
+		float OneOverSinthetaover2 = 1 / sqrt((1.0f) - (w * w));
 
-		return *this;
+		return Vec3(x * OneOverSinthetaover2, y * OneOverSinthetaover2, z * OneOverSinthetaover2);
 	}
 
-	Quaternion& Quaternion::operator*=(const Quaternion& Q)
+	Quaternion Conjugate(const Quaternion& Q)
 	{
-		*this = *this * Q;
-		return *this;
+		return Quaternion(Q.w, -Q.x, -Q.y, -Q.z);
 	}
 
-	float Quaternion::GetRotationAngle()
+	Quaternion Log(const Quaternion& Q)
 	{
-		return (acos2(w * 2));
+		float VectorLength = std::sqrt((Q.x * Q.x) + (Q.y * Q.y) + (Q.z * Q.z));
+		float Length = std::sqrt((Q.w * Q.w) + (VectorLength * VectorLength));
+
+		//atan2 keeps the angle accurate near 0 and Pi, where acos of w isn't.
+		float Scale = (VectorLength > 0.0f) ? std::atan2(VectorLength, Q.w) / VectorLength : 0.0f;
+
+		return Quaternion(std::log(Length), Q.x * Scale, Q.y * Scale, Q.z * Scale);
 	}
 
-	Vec3 Quaternion::GetRotationAxis()
+	Quaternion Exp(const Quaternion& Q)
 	{
-		float OneOverSinthetaover2 = 1 / sqrt((1.0f) - (w * w));
+		float VectorLength = std::sqrt((Q.x * Q.x) + (Q.y * Q.y) + (Q.z * Q.z));
+		float ExpW = std::exp(Q.w);
 
-		return Vec3(x * OneOverSinthetaover2, y * OneOverSinthetaover2, z * OneOverSinthetaover2);
+		//sin(l) / l goes to 1 as l goes to 0.
+		float Scale = (VectorLength > 0.0f) ? ExpW * std::sin(VectorLength) / VectorLength : ExpW;
+
+		return Quaternion(ExpW * std::cos(VectorLength), Q.x * Scale, Q.y * Scale, Q.z * Scale);
 	}
 
-	void Quaternion::Normalize()
+	Quaternion Expo(const Quaternion& Q, float Exponent)
 	{
-		float mag = (w * w) + (x * x) + (y * y) + (z * z);
+		return Exp(Log(Q) * Exponent);
+	}
 
-		if (mag >= 0.0f)
-		{
-			this->w *= 1.0f / sqrt(mag);
-			this->x *= 1.0f / sqrt(mag);
-			this->y *= 1.0f / sqrt(mag);
-			this->z *= 1.0f / sqrt(mag);
-		}
+	//Sums the products of the four components of a and b in order w, x, y, z, for four
+	//quaternions at once, each component held in one register. Rounds as SIMD::Dot4.
+	static inline SIMD::Float4 Dot4Lanes(const SIMD::Float4* a, const SIMD::Float4* b)
+	{
+		SIMD::Float4 Result = SIMD::Mul(a[0], b[0]);
+		Result = SIMD::Add(Result, SIMD::Mul(a[1], b[1]));
+		Result = SIMD::Add(Result, SIMD::Mul(a[2], b[2]));
+		return SIMD::Add(Result, SIMD::Mul(a[3], b[3]));
+	}
 
-		else
+	//Weights of From and To in Slerp, for the cosine of the angle between them, not negative.
+	static inline void SlerpWeights(float CosOmega, float t, float& k0, float& k1)
+	{
+		//Very close, lerp to avoid dividing by almost zero.
+		if (CosOmega > 0.9999f)
 		{
-			//std::cerr << "Invalid Magnitude" << std::endl; assert(false);
+			k0 = 1.0f - t;
+			k1 = t;
+			return;
 		}
+
+		float SinOmega = std::sqrt(1.0f - (CosOmega * CosOmega));
+		float Omega = std::atan2(SinOmega, CosOmega);
+		float OneOverSinOmega = 1.0f / SinOmega;
+
+		k0 = std::sin((1.0f - t) * Omega) * OneOverSinOmega;
+		k1 = std::sin(t * Omega) * OneOverSinOmega;
 	}
 
-	float DotProduct(const Quaternion& Q, const Quaternion& P)
+	//The corrected t of Nlerp, for the cosine of the angle between From and To, not negative.
+	//Bends t by a cubic so the normalized lerp keeps pace with Slerp, the coefficients fitted
+	//over the whole range of angles (as in Kapoulkine's "Approximating slerp").
+	static inline SIMD::Float4 NlerpFactor(SIMD::Float4 CosOmega, SIMD::Float4 t)
 	{
-		return ((Q.w * P.w) + (Q.x * P.x) + (Q.y * P.y) + (Q.z * P.z));
+		SIMD::Float4 d = CosOmega;
+		SIMD::Float4 A = SIMD::Add(SIMD::Splat(1.0904f), SIMD::Mul(d, SIMD::Add(SIMD::Splat(-3.2452f),
+			SIMD::Mul(d, SIMD::Sub(SIMD::Splat(3.55645f), SIMD::Mul(d, SIMD::Splat(1.43519f)))))));
+		SIMD::Float4 B = SIMD::Add(SIMD::Splat(0.848013f), SIMD::Mul(d, SIMD::Add(SIMD::Splat(-1.06021f),
+			SIMD::Mul(d, SIMD::Splat(0.215638f)))));
+
+		SIMD::Float4 Centered = SIMD::Sub(t, SIMD::Splat(0.5f));
+		SIMD::Float4 k = SIMD::Add(SIMD::Mul(SIMD::Mul(A, Centered), Centered), B);
+
+		SIMD::Float4 Bend = SIMD::Mul(SIMD::Mul(SIMD::Mul(t, Centered), SIMD::Sub(t, SIMD::Splat(1.0f))), k);
+		return SIMD::Add(t, Bend);
 	}
 
-	Quaternion Conjugate(const Quaternion& Q)
+	Quaternion Slerp(const Quaternion& From, const Quaternion& To, float t)
 	{
-		return Quaternion(Q.w, -Q.x, -Q.y, -Q.z);
+		SIMD::Float4 a = From.Load();
+		SIMD::Float4 b = To.Load();
+		float CosOmega = SIMD::Dot4(a, b);
+
+		//q and -q are the same rotation, take the one on the shorter arc.
+		b = SIMD::MulSign(b, SIMD::Splat(CosOmega));
+
+		float k0, k1;
+		SlerpWeights(std::fabs(CosOmega), t, k0, k1);
+
+		return Quaternion(SIMD::Add(SIMD::Mul(a, SIMD::Splat(k0)), SIMD::Mul(b, SIMD::Splat(k1))));
+	}
+
+	Quaternion Nlerp(const Quaternion& From, const Quaternion& To, float t)
+	{
+		SIMD::Float4 a = From.Load();
+		SIMD::Float4 b = To.Load();
+		float CosOmega = SIMD::Dot4(a, b);
+
+		b = SIMD::MulSign(b, SIMD::Splat(CosOmega));
+
+		SIMD::Float4 t1 = NlerpFactor(SIMD::Splat(std::fabs(CosOmega)), SIMD::Splat(t));
+		SIMD::Float4 t0 = SIMD::Sub(SIMD::Splat(1.0f), t1);
+
+		SIMD::Float4 Result = SIMD::Add(SIMD::Mul(a, t0), SIMD::Mul(b, t1));
+		return Quaternion(SIMD::Normalize(Result, SIMD::Dot4(Result, Result)));
+	}
+
+	//Loads four quaternions and transposes them, so register i holds component i of all four.
+	static inline void LoadLanes(const Quaternion* Q, SIMD::Float4* Lanes)
+	{
+		for (int i = 0; i < 4; i++)
+			Lanes[i] = Q[i].Load();
+
+		SIMD::Transpose4(Lanes[0], Lanes[1], Lanes[2], Lanes[3]);
+	}
+
+	static inline void StoreLanes(Quaternion* Q, SIMD::Float4* Lanes)
+	{
+		SIMD::Transpose4(Lanes[0], Lanes[1], Lanes[2], Lanes[3]);
+
+		for (int i = 0; i < 4; i++)
+			Q[i] = Quaternion(Lanes[i]);
+	}
+
+	void Slerp(const Quaternion* From, const Quaternion* To, Quaternion* Out, unsigned Count, float t)
+	{
+		unsigned i = 0;
+		for (; i + 4 <= Count; i += 4)
+		{
+			SIMD::Float4 a[4], b[4];
+			LoadLanes(From + i, a);
+			LoadLanes(To + i, b);
+
+			SIMD::Float4 CosOmega = Dot4Lanes(a, b);
+			for (int j = 0; j < 4; j++)
+				b[j] = SIMD::MulSign(b[j], CosOmega);
+
+			//There is no packed sin, the weights are worked out one by one.
+			alignas(16) float Cosines[4];
+			alignas(16) float k0[4];
+			alignas(16) float k1[4];
+			SIMD::StoreAligned(Cosines, SIMD::Abs(CosOmega));
+			for (int j = 0; j < 4; j++)
+				SlerpWeights(Cosines[j], t, k0[j], k1[j]);
+
+			SIMD::Float4 Weight0 = SIMD::LoadAligned(k0);
+			SIMD::Float4 Weight1 = SIMD::LoadAligned(k1);
+
+			SIMD::Float4 Result[4];
+			for (int j = 0; j < 4; j++)
+				Result[j] = SIMD::Add(SIMD::Mul(a[j], Weight0), SIMD::Mul(b[j], Weight1));
+
+			StoreLanes(Out + i, Result);
+		}
+
+		for (; i < Count; i++)
+			Out[i] = Slerp(From[i], To[i], t);
+	}
+
+	void Nlerp(const Quaternion* From, const Quaternion* To, Quaternion* Out, unsigned Count, float t)
+	{
+		const SIMD::Float4 T = SIMD::Splat(t);
+
+		unsigned i = 0;
+		for (; i + 4 <= Count; i += 4)
+		{
+			SIMD::Float4 a[4], b[4];
+			LoadLanes(From + i, a);
+			LoadLanes(To + i, b);
+
+			SIMD::Float4 CosOmega = Dot4Lanes(a, b);
+			for (int j = 0; j < 4; j++)
+				b[j] = SIMD::MulSign(b[j], CosOmega);
+
+			SIMD::Float4 t1 = NlerpFactor(SIMD::Abs(CosOmega), T);
+			SIMD::Float4 t0 = SIMD::Sub(SIMD::Splat(1.0f), t1);
+
+			SIMD::Float4 Result[4];
+			for (int j = 0; j < 4; j++)
+				Result[j] = SIMD::Add(SIMD::Mul(a[j], t0), SIMD::Mul(b[j], t1));
+
+			SIMD::Float4 OneOverLength = SIMD::Div(SIMD::Splat(1.0f), SIMD::Sqrt(Dot4Lanes(Result, Result)));
+			for (int j = 0; j < 4; j++)
+				Result[j] = SIMD::Mul(Result[j], OneOverLength);
+
+			StoreLanes(Out + i, Result);
+		}
+
+		for (; i < Count; i++)
+			Out[i] = Nlerp(From[i], To[i], t);
 	}
 }
\ No newline at end of file
@@ -5,24 +5,38 @@
 #include <cassert>
 #include "Vec3.h"
 #include "Math_Util.h"
+#include "SIMD.h"
 
 namespace CrunchMath {
 
-	struct Quaternion
+	struct alignas(16) Quaternion
 	{
 		float w, x, y, z;
 
-		Quaternion();
+		Quaternion()
+			:w(0.0f), x(0.0f), y(0.0f), z(0.0f) {}
 
-		Quaternion(float m_w, float m_x, float m_y, float m_z);
+		Quaternion(float m_w, float m_x, float m_y, float m_z)
+			:w(m_w), x(m_x), y(m_y), z(m_z) {}
 
-		Quaternion(float w, Vec3 v);
+		Quaternion(float m_w, Vec3 v)
+			:w(m_w), x(v.x), y(v.y), z(v.z) {}
 
-		Quaternion(const Quaternion& Q);
+		explicit Quaternion(SIMD::Float4 q)
+		{
+			SIMD::Store(&w, q);
+		}
+
+		Quaternion(const Quaternion& Q) = default;
+
+		SIMD::Float4 Load() const
+		{
+			return SIMD::Load(&w);
+		}
 
 		void SetToIdentity();
 		
-		Quaternion& operator=(const Quaternion& Q);
+		Quaternion& operator=(const Quaternion& Q) = default;
 
 		void SetToRotateAboutX(float radian);
 
@@ -36,25 +50,97 @@ namespace CrunchMath {
 
 		void SetToRotateAboutAxis(Vec3 v, float radian);
 
-		Quaternion operator*(const Quaternion& Q);
-
-		Quaternion& operator+=(const Quaternion& Q);
-
-		Quaternion& operator*=(const Quaternion& Q);
+		Quaternion operator*(const Quaternion& Q) const
+		{
+			return Quaternion(SIMD::QuaternionProduct(Load(), Q.Load()));
+		}
+
+		Quaternion& operator*=(const Quaternion& Q)
+		{
+			return *this = *this * Q;
+		}
+
+		Quaternion operator+(const Quaternion& Q) const
+		{
+			return Quaternion(SIMD::Add(Load(), Q.Load()));
+		}
+
+		Quaternion& operator+=(const Quaternion& Q)
+		{
+			return *this = *this + Q;
+		}
+
+		Quaternion operator-(const Quaternion& Q) const
+		{
+			return Quaternion(SIMD::Sub(Load(), Q.Load()));
+		}
+
+		Quaternion& operator-=(const Quaternion& Q)
+		{
+			return *this = *this - Q;
+		}
+
+		Quaternion operator*(const float& Scale) const
+		{
+			return Quaternion(SIMD::Mul(Load(), SIMD::Splat(Scale)));
+		}
+
+		Quaternion& operator*=(const float& Scale)
+		{
+			return *this = *this * Scale;
+		}
+
+		Quaternion operator- () const
+		{
+			return Quaternion(SIMD::Negate(Load()));
+		}
 
 		float GetRotationAngle();
 
 		Vec3 GetRotationAxis();
 
-		void Normalize();
+		void Normalize()
+		{
+			float mag = SIMD::Dot4(Load(), Load());
+
+			if (mag >= 0.0f)
+				*this = Quaternion(SIMD::Normalize(Load(), mag));
 
+			else
+			{
+				//std::cerr << "Invalid Magnitude" << std::endl; assert(false);
+			}
+		}
 	};
 
-	float DotProduct(const Quaternion& Q, const Quaternion& P);
+	static inline float DotProduct(const Quaternion& Q, const Quaternion& P)
+	{
+		return SIMD::Dot4(Q.Load(), P.Load());
+	}
 	
-	Quaternion Expo(/*Parameter*/);
+	//Returns the logarithm of Q, (ln|Q|, theta * n) for Q = |Q| * (cos theta, sin theta * n).
+	Quaternion Log(const Quaternion& Q);
+
+	//Returns e raised to Q, the inverse of Log.
+	Quaternion Exp(const Quaternion& Q);
+
+	//Raises the unit quaternion Q to the given power, which scales the angle it rotates by.
+	Quaternion Expo(const Quaternion& Q, float Exponent);
+
+	//Interpolates along the shorter arc from the unit quaternion From to To, at a constant angular rate.
+	Quaternion Slerp(const Quaternion& From, const Quaternion& To, float t);
+
+	//Approximates Slerp without any trig: a normalized lerp, with t corrected for the angle between
+	//From and To. The rotation stays within 8e-4 radians of Slerp's for any pair of unit quaternions,
+	//plain normalized lerp strays up to 0.14 radians.
+	Quaternion Nlerp(const Quaternion& From, const Quaternion& To, float t);
+
+	//Out[i] = Slerp(From[i], To[i], t) for whole arrays, four at a time through SIMD, with results
+	//equal to the single versions. Out may be From or To.
+	void Slerp(const Quaternion* From, const Quaternion* To, Quaternion* Out, unsigned Count, float t);
 
-	Quaternion Slerp(/*Parameter*/);
+	//Out[i] = Nlerp(From[i], To[i], t), as the batched Slerp.
+	void Nlerp(const Quaternion* From, const Quaternion* To, Quaternion* Out, unsigned Count, float t);
 
 	Quaternion Conjugate(const Quaternion& Q);
 }
\ No newline at end of file
@@ -0,0 +1,222 @@
+#pragma once
+#include <cmath>
+
+// Picks the instruction set Vec3, Vec4 and Quaternion are built on.
+// Define CM_SIMD_SCALAR before including CrunchMath to force the plain
+// C++ path, every backend gives the same results bit for bit.
+#if !defined(CM_SIMD_SCALAR)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CM_SIMD_SSE
+#else
+#define CM_SIMD_SCALAR
+#endif
+#endif
+
+namespace CrunchMath {
+
+	namespace SIMD {
+
+		// Everything below works on four floats at once, the math types
+		// load themselves into a Float4, do their work and store it back.
+		// A backend for another instruction set (NEON, say) only has to
+		// provide this same set of functions.
+		//
+		// The dot products add their lanes in order (x + y) + z (+ w), not
+		// pairwise, so they round exactly as the scalar code does.
+
+#if defined(CM_SIMD_SSE)
+		typedef __m128 Float4;
+
+		static inline Float4 Load(const float* p) { return _mm_loadu_ps(p); }
+
+		static inline void Store(float* p, Float4 a) { _mm_storeu_ps(p, a); }
+
+		// As Load and Store, for addresses known to be 16 byte aligned.
+		static inline Float4 LoadAligned(const float* p) { return _mm_load_ps(p); }
+
+		static inline void StoreAligned(float* p, Float4 a) { _mm_store_ps(p, a); }
+
+		static inline Float4 Set(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+
+		// Loads three floats, the fourth lane comes out zero. p only needs the
+		// alignment of a float, Mat3x3 columns start every 12 bytes.
+		static inline Float4 Load3(const float* p)
+		{
+			return _mm_movelh_ps(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p))), _mm_load_ss(p + 2));
+		}
+
+		// Stores the first three lanes, leaving whatever follows them alone.
+		static inline void Store3(float* p, Float4 a)
+		{
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_castps_si128(a));
+			_mm_store_ss(p + 2, _mm_movehl_ps(a, a));
+		}
+
+		// Replaces the fourth lane of a by w.
+		static inline Float4 SetW(Float4 a, float w)
+		{
+			return _mm_shuffle_ps(a, _mm_unpackhi_ps(a, _mm_set1_ps(w)), _MM_SHUFFLE(1, 0, 1, 0));
+		}
+
+		static inline Float4 Splat(float s) { return _mm_set1_ps(s); }
+
+		static inline Float4 Add(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+
+		static inline Float4 Sub(Float4 a, Float4 b) { return _mm_sub_ps(a, b); }
+
+		static inline Float4 Mul(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+
+		static inline Float4 Div(Float4 a, Float4 b) { return _mm_div_ps(a, b); }
+
+		static inline Float4 Negate(Float4 a) { return _mm_xor_ps(a, _mm_set1_ps(-0.0f)); }
+
+		static inline Float4 Abs(Float4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+
+		static inline Float4 Sqrt(Float4 a) { return _mm_sqrt_ps(a); }
+
+		// Flips the sign of a in the lanes where s is negative.
+		static inline Float4 MulSign(Float4 a, Float4 s) { return _mm_xor_ps(a, _mm_and_ps(s, _mm_set1_ps(-0.0f))); }
+
+		static inline float Dot3(Float4 a, Float4 b)
+		{
+			__m128 m = _mm_mul_ps(a, b);
+			__m128 s = _mm_add_ss(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1)));
+			s = _mm_add_ss(s, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 2, 2, 2)));
+			return _mm_cvtss_f32(s);
+		}
+
+		static inline float Dot4(Float4 a, Float4 b)
+		{
+			__m128 m = _mm_mul_ps(a, b);
+			__m128 s = _mm_add_ss(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1)));
+			s = _mm_add_ss(s, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 2, 2, 2)));
+			s = _mm_add_ss(s, _mm_shuffle_ps(m, m, _MM_SHUFFLE(3, 3, 3, 3)));
+			return _mm_cvtss_f32(s);
+		}
+
+		// The w lane comes out as a.w * b.w - a.w * b.w.
+		static inline Float4 Cross3(Float4 a, Float4 b)
+		{
+			__m128 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+			__m128 aZXY = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2));
+			__m128 bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+			__m128 bZXY = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2));
+			return _mm_sub_ps(_mm_mul_ps(aYZX, bZXY), _mm_mul_ps(aZXY, bYZX));
+		}
+
+		static inline void Transpose4(Float4& a, Float4& b, Float4& c, Float4& d)
+		{
+			_MM_TRANSPOSE4_PS(a, b, c, d);
+		}
+
+		// Hamilton product of two quaternions stored w, x, y, z. Each lane
+		// sums its four terms in the same order as Quaternion::operator*.
+		static inline Float4 QuaternionProduct(Float4 a, Float4 b)
+		{
+			const __m128 SignWXYZ = _mm_setr_ps(-0.0f, 0.0f, 0.0f, 0.0f);
+
+			__m128 t0 = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0)), b);
+			__m128 t1 = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 2, 1, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 0, 0, 1)));
+			__m128 t2 = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 1, 3, 2)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 3, 2, 2)));
+			__m128 t3 = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 3, 2, 3)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 1, 3, 3)));
+
+			__m128 r = _mm_add_ps(t0, _mm_xor_ps(t1, SignWXYZ));
+			r = _mm_add_ps(r, _mm_xor_ps(t2, SignWXYZ));
+			return _mm_sub_ps(r, t3);
+		}
+
+#else
+		struct Float4
+		{
+			float v[4];
+		};
+
+		static inline Float4 Load(const float* p) { return Float4{ { p[0], p[1], p[2], p[3] } }; }
+
+		static inline void Store(float* p, Float4 a) { p[0] = a.v[0]; p[1] = a.v[1]; p[2] = a.v[2]; p[3] = a.v[3]; }
+
+		static inline Float4 LoadAligned(const float* p) { return Load(p); }
+
+		static inline void StoreAligned(float* p, Float4 a) { Store(p, a); }
+
+		static inline Float4 Set(float x, float y, float z, float w) { return Float4{ { x, y, z, w } }; }
+
+		static inline Float4 Load3(const float* p) { return Float4{ { p[0], p[1], p[2], 0.0f } }; }
+
+		static inline void Store3(float* p, Float4 a) { p[0] = a.v[0]; p[1] = a.v[1]; p[2] = a.v[2]; }
+
+		static inline Float4 SetW(Float4 a, float w) { a.v[3] = w; return a; }
+
+		static inline Float4 Splat(float s) { return Float4{ { s, s, s, s } }; }
+
+		static inline Float4 Add(Float4 a, Float4 b) { return Float4{ { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } }; }
+
+		static inline Float4 Sub(Float4 a, Float4 b) { return Float4{ { a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] } }; }
+
+		static inline Float4 Mul(Float4 a, Float4 b) { return Float4{ { a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] } }; }
+
+		static inline Float4 Div(Float4 a, Float4 b) { return Float4{ { a.v[0] / b.v[0], a.v[1] / b.v[1], a.v[2] / b.v[2], a.v[3] / b.v[3] } }; }
+
+		static inline Float4 Negate(Float4 a) { return Float4{ { -a.v[0], -a.v[1], -a.v[2], -a.v[3] } }; }
+
+		static inline Float4 Abs(Float4 a) { return Float4{ { std::fabs(a.v[0]), std::fabs(a.v[1]), std::fabs(a.v[2]), std::fabs(a.v[3]) } }; }
+
+		static inline Float4 Sqrt(Float4 a) { return Float4{ { std::sqrt(a.v[0]), std::sqrt(a.v[1]), std::sqrt(a.v[2]), std::sqrt(a.v[3]) } }; }
+
+		static inline Float4 MulSign(Float4 a, Float4 s)
+		{
+			for (int i = 0; i < 4; i++)
+				a.v[i] = std::signbit(s.v[i]) ? -a.v[i] : a.v[i];
+			return a;
+		}
+
+		static inline float Dot3(Float4 a, Float4 b)
+		{
+			return a.v[0] * b.v[0] + a.v[1] * b.v[1] + a.v[2] * b.v[2];
+		}
+
+		static inline float Dot4(Float4 a, Float4 b)
+		{
+			return a.v[0] * b.v[0] + a.v[1] * b.v[1] + a.v[2] * b.v[2] + a.v[3] * b.v[3];
+		}
+
+		static inline Float4 Cross3(Float4 a, Float4 b)
+		{
+			return Float4{ {
+				a.v[1] * b.v[2] - a.v[2] * b.v[1],
+				a.v[2] * b.v[0] - a.v[0] * b.v[2],
+				a.v[0] * b.v[1] - a.v[1] * b.v[0],
+				a.v[3] * b.v[3] - a.v[3] * b.v[3]
+			} };
+		}
+
+		static inline void Transpose4(Float4& a, Float4& b, Float4& c, Float4& d)
+		{
+			Float4 r[4] = { a, b, c, d };
+			a = Float4{ { r[0].v[0], r[1].v[0], r[2].v[0], r[3].v[0] } };
+			b = Float4{ { r[0].v[1], r[1].v[1], r[2].v[1], r[3].v[1] } };
+			c = Float4{ { r[0].v[2], r[1].v[2], r[2].v[2], r[3].v[2] } };
+			d = Float4{ { r[0].v[3], r[1].v[3], r[2].v[3], r[3].v[3] } };
+		}
+
+		static inline Float4 QuaternionProduct(Float4 a, Float4 b)
+		{
+			const float* p = a.v; const float* q = b.v;
+			return Float4{ {
+				p[0] * q[0] - p[1] * q[1] - p[2] * q[2] - p[3] * q[3],
+				p[0] * q[1] + p[1] * q[0] + p[3] * q[2] - p[2] * q[3],
+				p[0] * q[2] + p[2] * q[0] + p[1] * q[3] - p[3] * q[1],
+				p[0] * q[3] + p[3] * q[0] + p[2] * q[1] - p[1] * q[2]
+			} };
+		}
+#endif
+
+		// Scales a by the inverse of its length, computed from the given
+		// squared length, in single precision on every backend.
+		static inline Float4 Normalize(Float4 a, float SquaredLength)
+		{
+			return Mul(a, Splat(1.0f / std::sqrt(SquaredLength)));
+		}
+	}
+}
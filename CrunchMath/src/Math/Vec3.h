@@ -2,87 +2,161 @@
 #include <cassert>
 #include <cmath>
 #include <iostream>
+#include "SIMD.h"
 
 namespace CrunchMath {
 
-	struct Vec3
+	// Padded to 16 bytes and aligned so a Vec3 loads into one SIMD register,
+	// the fourth lane is kept at zero. The constructors write all 16 bytes at
+	// once, so a Vec3 just built can be loaded back without a stall.
+	struct alignas(16) Vec3
 	{
 		float x, y, z;
-		
-		Vec3();
 
-		Vec3(float xc, float yc, float zc);
-
-		Vec3(const Vec3& u);
-
-		float operator[](unsigned i) const;
-
-		float& operator[](unsigned i);
-
-		Vec3& operator=(const Vec3 &u);
-
-		Vec3 operator+(const Vec3& u) const;
-
-		Vec3& operator+=(const Vec3 &u);
-
-		Vec3 operator-(const Vec3& u) const;
-
-		Vec3& operator-=(const Vec3 &u);
-
-		Vec3 operator*(const Vec3& u) const;
-
-		Vec3& operator*=(const Vec3& u);
-
-		Vec3 operator*(const float& Scale) const;
-
-		Vec3& operator*=(const float& Scale);
-
-		Vec3 operator/(const float& Scale) const;
-
-		Vec3& operator/=(const float& Scale);
-
-		Vec3 operator- () const;
-
-		bool operator==(Vec3& u);
-
-		bool operator!=(Vec3& u);
-
-		void Normalize();
+		float Pad;
+
+		Vec3()
+		{
+			SIMD::Store(&x, SIMD::Splat(0.0f));
+		}
+
+		Vec3(float xc, float yc, float zc)
+		{
+			SIMD::Store(&x, SIMD::Set(xc, yc, zc, 0.0f));
+		}
+
+		explicit Vec3(SIMD::Float4 v)
+		{
+			SIMD::Store(&x, v);
+		}
+
+		Vec3(const Vec3& u) = default;
+
+		Vec3& operator=(const Vec3& u) = default;
+
+		SIMD::Float4 Load() const
+		{
+			return SIMD::Load(&x);
+		}
+
+		float operator[](unsigned i) const
+		{
+			if (i == 0) return x;
+			if (i == 1) return y;
+			return z;
+		}
+
+		float& operator[](unsigned i)
+		{
+			if (i == 0) return x;
+			if (i == 1) return y;
+			return z;
+		}
+
+		Vec3 operator+(const Vec3& u) const
+		{
+			return Vec3(SIMD::Add(Load(), u.Load()));
+		}
+
+		Vec3& operator+=(const Vec3& u)
+		{
+			return *this = *this + u;
+		}
+
+		Vec3 operator-(const Vec3& u) const
+		{
+			return Vec3(SIMD::Sub(Load(), u.Load()));
+		}
+
+		Vec3& operator-=(const Vec3& u)
+		{
+			return *this = *this - u;
+		}
+
+		Vec3 operator*(const Vec3& u) const
+		{
+			return Vec3(SIMD::Mul(Load(), u.Load()));
+		}
+
+		Vec3& operator*=(const Vec3& u)
+		{
+			return *this = *this * u;
+		}
+
+		Vec3 operator*(const float& Scale) const
+		{
+			return Vec3(SIMD::Mul(Load(), SIMD::Splat(Scale)));
+		}
+
+		Vec3& operator*=(const float& Scale)
+		{
+			return *this = *this * Scale;
+		}
+
+		Vec3 operator/(const float& Scale) const
+		{
+			return Vec3(SIMD::Div(Load(), SIMD::Splat(Scale)));
+		}
+
+		Vec3& operator/=(const float& Scale)
+		{
+			return *this = *this / Scale;
+		}
+
+		Vec3 operator- () const
+		{
+			return Vec3(SIMD::Negate(Load()));
+		}
+
+		bool operator==(const Vec3& u) const
+		{
+			return (x == u.x && y == u.y && z == u.z);
+		}
+
+		bool operator!=(const Vec3& u) const
+		{
+			return (x != u.x || y != u.y || z != u.z);
+		}
+
+		void Normalize()
+		{
+			float mag = SIMD::Dot3(Load(), Load());
+			if (mag <= 0.0f)
+				return;
+
+			else if (mag > 0.0f)
+				*this = Vec3(SIMD::Normalize(Load(), mag));
+
+			else
+			{
+				std::cout << "Invalid Magnitude" << std::endl; assert(false);
+			}
+		}
 	};
 
 	static inline Vec3 CrossProduct(const Vec3& lhs, const Vec3& rhs)
 	{
-		return Vec3
-		(
-			lhs.y * rhs.z - lhs.z * rhs.y,
-			lhs.z * rhs.x - lhs.x * rhs.z,
-			lhs.x * rhs.y - lhs.y * rhs.x
-		);
+		return Vec3(SIMD::Cross3(lhs.Load(), rhs.Load()));
 	}
 
 	static inline Vec3 Abs(const Vec3& v)
 	{
-		return Vec3(fabs(v.x), fabs(v.y), fabs(v.z));
+		return Vec3(SIMD::Abs(v.Load()));
 	}
 
 	static inline Vec3 Scale(const float Scaler, const Vec3& rhs)
 	{
-		return Vec3(Scaler * rhs.x, Scaler * rhs.y, Scaler * rhs.z);
+		return Vec3(SIMD::Mul(SIMD::Splat(Scaler), rhs.Load()));
 	}
 
 	static inline float Distance(const Vec3& lhs, const Vec3& rhs)
 	{
-		return
-			(sqrt(
-				((lhs.x - rhs.x) * (lhs.x - rhs.x)) +
-				((lhs.y - rhs.y) * (lhs.y - rhs.y)) +
-				((lhs.z - rhs.z) * (lhs.z - rhs.z))
-			)
-				);
+		SIMD::Float4 d = SIMD::Sub(lhs.Load(), rhs.Load());
+		return std::sqrt(SIMD::Dot3(d, d));
 	}
 
 	static inline float DotProduct(const Vec3& lhs, const Vec3& rhs)
 	{
-		return ((lhs.x * rhs.x) + (lhs.y * rhs.y) + (lhs.z * rhs.z));
+		return SIMD::Dot3(lhs.Load(), rhs.Load());
 	}
-}
\ No newline at end of file
+}
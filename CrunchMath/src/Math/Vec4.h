@@ -2,19 +2,109 @@
 #include <cassert>
 #include <cmath>
 #include <iostream>
+#include "SIMD.h"
 
 namespace CrunchMath {
 
-	struct Vec4
+	struct alignas(16) Vec4
 	{
 		float x, y, z, a;
 		
-		Vec4();
+		Vec4()
+			:x(0.0f), y(0.0f), z(0.0f), a(0.0f) {}
 
-		Vec4(float xc, float yc, float zc, float ac);
+		Vec4(float xc, float yc, float zc, float ac)
+			: x(xc), y(yc), z(zc), a(ac) {}
 
-		Vec4(const Vec4& u);
+		explicit Vec4(SIMD::Float4 v)
+		{
+			SIMD::Store(&x, v);
+		}
 
-		Vec4& operator=(const Vec4& u);
+		Vec4(const Vec4& u) = default;
+
+		Vec4& operator=(const Vec4& u) = default;
+
+		SIMD::Float4 Load() const
+		{
+			return SIMD::Load(&x);
+		}
+
+		Vec4 operator+(const Vec4& u) const
+		{
+			return Vec4(SIMD::Add(Load(), u.Load()));
+		}
+
+		Vec4& operator+=(const Vec4& u)
+		{
+			return *this = *this + u;
+		}
+
+		Vec4 operator-(const Vec4& u) const
+		{
+			return Vec4(SIMD::Sub(Load(), u.Load()));
+		}
+
+		Vec4& operator-=(const Vec4& u)
+		{
+			return *this = *this - u;
+		}
+
+		Vec4 operator*(const Vec4& u) const
+		{
+			return Vec4(SIMD::Mul(Load(), u.Load()));
+		}
+
+		Vec4& operator*=(const Vec4& u)
+		{
+			return *this = *this * u;
+		}
+
+		Vec4 operator*(const float& Scale) const
+		{
+			return Vec4(SIMD::Mul(Load(), SIMD::Splat(Scale)));
+		}
+
+		Vec4& operator*=(const float& Scale)
+		{
+			return *this = *this * Scale;
+		}
+
+		Vec4 operator/(const float& Scale) const
+		{
+			return Vec4(SIMD::Div(Load(), SIMD::Splat(Scale)));
+		}
+
+		Vec4& operator/=(const float& Scale)
+		{
+			return *this = *this / Scale;
+		}
+
+		Vec4 operator- () const
+		{
+			return Vec4(SIMD::Negate(Load()));
+		}
+
+		bool operator==(const Vec4& u) const
+		{
+			return (x == u.x && y == u.y && z == u.z && a == u.a);
+		}
+
+		bool operator!=(const Vec4& u) const
+		{
+			return !(*this == u);
+		}
+
+		void Normalize()
+		{
+			float mag = SIMD::Dot4(Load(), Load());
+			if (mag > 0.0f)
+				*this = Vec4(SIMD::Normalize(Load(), mag));
+		}
 	};
-}
\ No newline at end of file
+
+	static inline float DotProduct(const Vec4& lhs, const Vec4& rhs)
+	{
+		return SIMD::Dot4(lhs.Load(), rhs.Load());
+	}
+}
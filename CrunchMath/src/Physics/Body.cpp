@@ -2,18 +2,57 @@
 #include <memory.h>
 #include <assert.h>
 #include "Body.h"
+#include "BodyStore.h"
 
 namespace CrunchMath
 {
     float SleepEpsilon = ((float)0.3);
 
-    static inline void TransformInertiaTensor(Mat3x3& iitWorld, const Mat3x3& iitBody, const Mat4x4& rotmat)
-    {
-        Mat3x3 LocalToWorld(rotmat.GetColumnVector(0), rotmat.GetColumnVector(1), rotmat.GetColumnVector(2));
-        Mat3x3 TransposeInverseLocalToWorld = Invert(LocalToWorld);
-        TransposeInverseLocalToWorld.Transpose();
+    /**
+     * Returns the inverse inertia tensor in world space, R * iitBody * R^T
+     * for the rotation R of the body. R is orthonormal, so its transpose
+     * stands in for its inverse and no matrix has to be inverted. A
+     * diagonal tensor, as boxes and spheres have, only scales the columns
+     * of R, which saves six of the multiplies.
+     */
+    static inline SymmetricTensor TransformInertiaTensor(const SymmetricTensor& iitBody, const Mat4x4& rotmat)
+    {
+        const float (*R)[4] = rotmat.Matrix;
+
+        // The columns of R, built from their elements since Rotate has just
+        // written them one float at a time.
+        SIMD::Float4 r0 = SIMD::Set(R[0][0], R[0][1], R[0][2], 0.0f);
+        SIMD::Float4 r1 = SIMD::Set(R[1][0], R[1][1], R[1][2], 0.0f);
+        SIMD::Float4 r2 = SIMD::Set(R[2][0], R[2][1], R[2][2], 0.0f);
+
+        // The columns of R * iitBody.
+        SIMD::Float4 m0, m1, m2;
+        if (iitBody.IsDiagonal())
+        {
+            m0 = SIMD::Mul(r0, SIMD::Splat(iitBody.XX));
+            m1 = SIMD::Mul(r1, SIMD::Splat(iitBody.YY));
+            m2 = SIMD::Mul(r2, SIMD::Splat(iitBody.ZZ));
+        }
+        else
+        {
+            m0 = SIMD::Add(SIMD::Add(SIMD::Mul(r0, SIMD::Splat(iitBody.XX)), SIMD::Mul(r1, SIMD::Splat(iitBody.XY))), SIMD::Mul(r2, SIMD::Splat(iitBody.XZ)));
+            m1 = SIMD::Add(SIMD::Add(SIMD::Mul(r0, SIMD::Splat(iitBody.XY)), SIMD::Mul(r1, SIMD::Splat(iitBody.YY))), SIMD::Mul(r2, SIMD::Splat(iitBody.YZ)));
+            m2 = SIMD::Add(SIMD::Add(SIMD::Mul(r0, SIMD::Splat(iitBody.XZ)), SIMD::Mul(r1, SIMD::Splat(iitBody.YZ))), SIMD::Mul(r2, SIMD::Splat(iitBody.ZZ)));
+        }
+
+        // Column b of the result is the columns of R * iitBody weighted by row
+        // b of R. The third column only contributes ZZ, the rest is symmetric.
+        alignas(16) float Result[3][4];
+        for (int b = 0; b < 3; b++)
+        {
+            SIMD::Float4 w = SIMD::Mul(m0, SIMD::Splat(R[0][b]));
+            w = SIMD::Add(w, SIMD::Mul(m1, SIMD::Splat(R[1][b])));
+            w = SIMD::Add(w, SIMD::Mul(m2, SIMD::Splat(R[2][b])));
+            SIMD::StoreAligned(Result[b], w);
+        }
 
-        iitWorld = TransposeInverseLocalToWorld * iitBody * Invert(LocalToWorld);
+        return SymmetricTensor{ Result[0][0], Result[1][1], Result[2][2],
+                                Result[1][0], Result[2][0], Result[2][1] };
     }
 
     static inline void CalculateTransformMatrix(Mat4x4& TransformMatrix, const Vec3& Position, const Quaternion& Orientation)
@@ -24,174 +63,131 @@ namespace CrunchMath
 
     Body::Body()
     {
-        Position = Vec3(0.0f, 0.0f, 0.0f);
-        Orientation = Quaternion(0.0f, 0.0f, 0.0f, 0.0f);
-        Velocity = Vec3(0.0f, 0.0f, 0.0f);
-        SetDamping(0.9f, 0.9f);
-        CalculateDerivedData();
     }
 
-    Body::Body(const Body& copybody)
+    Body& Body::operator=(const Body& copybody)
     {
         Copy(copybody);
+        return *this;
     }
 
-    Body& Body::operator=(const Body& copybody)
+    void Body::Bind(BodyStore* store, unsigned slot)
     {
-        Copy(copybody);
-        return *this;
+        Store = store;
+        Slot = slot;
+        Store->Reset(Slot);
+        InverseInertiaTensor = SymmetricTensor{ 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+        Size = Vec3(0.0f, 0.0f, 0.0f);
+        Filter = CollisionFilter();
+        CalculateDerivedData();
     }
 
     void Body::CalculateDerivedData()
     {
+        Quaternion Orientation = Store->Orientation.Get(Slot);
         Orientation.Normalize();
+        Store->Orientation.Set(Slot, Orientation);
 
+        CalculateTransform();
+    }
+
+    void Body::CalculateTransform()
+    {
         // Calculate the transform matrix for the body.
-        CalculateTransformMatrix(TransformMatrix, Position, Orientation);
+        CalculateTransformMatrix(TransformMatrix, Store->Position.Get(Slot), Store->Orientation.Get(Slot));
 
         // Calculate the inertiaTensor in world space.
-        TransformInertiaTensor(InverseInertiaTensorWorld, InverseInertiaTensor, TransformMatrix);
+        Store->InverseInertiaTensorWorld.Set(Slot, TransformInertiaTensor(InverseInertiaTensor, TransformMatrix));
     }
 
     void Body::Integrate(float duration)
     {
-        if (!IsAwake) return;
-
-        // Calculate linear Acceleration from force inputs.
-        LastFrameAcceleration = Acceleration;
-        LastFrameAcceleration += ForceAccumulation * InverseMass;
-
-        // Calculate angular Acceleration from torque inputs.
-        Vec3 angularAcceleration = InverseInertiaTensorWorld * TorqueAccumulation;
-
-        // Adjust velocities
-        // Update linear Velocity from both Acceleration and impulse.
-        Velocity += LastFrameAcceleration * duration;
-
-        // Update angular Velocity from both Acceleration and impulse.
-        Rotation += angularAcceleration * duration;
-
-        // Impose drag.
-        Velocity *= powf(LinearDamping, duration);
-        Rotation *= powf(AngularDamping, duration);
-
-        // Adjust Positions
-        // Update linear Position.
-        Position += Velocity * duration;
-
-        // Update angular Position. //To do=> Take away Quaternion later...
-        Quaternion q(0, Vec3(Rotation * duration));
-        q *= Orientation;
-        Orientation.w += q.w * ((float)0.5);
-        Orientation.x += q.x * ((float)0.5);
-        Orientation.y += q.y * ((float)0.5);
-        Orientation.z += q.z * ((float)0.5);
+        Store->Integrate(duration, Slot, Slot + 1);
 
         // Normalise the Orientation, and update the matrices with the new
         // Position and Orientation
-        CalculateDerivedData();
-
-        // Clear accumulators.
-        ClearAccumulators();
-
-        // Update the kinetic energy store, and possibly put the body to
-        // sleep.
-        if (CanSleep) {
-            float currentMotion = DotProduct(Velocity, Velocity) + DotProduct(Rotation, Rotation);
-
-            float bias = powf(0.5, duration);
-            Motion = bias * Motion + (1 - bias) * currentMotion;
-
-            if (Motion < SleepEpsilon) SetAwake(false);
-            else if (Motion > 10 * SleepEpsilon) Motion = 10 * SleepEpsilon;
-        }
+        if (Store->WasIntegrated(Slot))
+            CalculateDerivedData();
     }
 
     void Body::SetMass(const float mass)
     {
+        if (Type != bt_Dynamic)
+            return;
+
         if (mass <= 0.0f)
-            InverseMass = 0.0f;
+            Store->InverseMass[Slot] = 0.0f;
         else
-            InverseMass = ((float)1.0) / mass;
+            Store->InverseMass[Slot] = ((float)1.0) / mass;
     }
 
     float Body::GetMass() const
     {
-        if (InverseMass == 0) {
+        if (Store->InverseMass[Slot] == 0) {
             return FLT_MAX;
         }
         else {
-            return ((float)1.0) / InverseMass;
+            return ((float)1.0) / Store->InverseMass[Slot];
         }
     }
 
-    float Body::GetInverseMass() const
-    {
-        return InverseMass;
-    }
-
     void Body::SetInertiaTensor(const Mat3x3& inertiaTensor)
     {
-        InverseInertiaTensor = Invert(inertiaTensor);
+        if (Type != bt_Dynamic)
+            return;
+
+        InverseInertiaTensor = SymmetricTensor::FromMatrix(Invert(inertiaTensor));
     }
 
     void Body::GetInertiaTensorWorld(Mat3x3& inertiaTensor) const
     {
+        Mat3x3 InverseInertiaTensorWorld;
+        GetInverseInertiaTensorWorld(InverseInertiaTensorWorld);
         inertiaTensor = Invert(InverseInertiaTensorWorld);
     }
 
     void Body::GetInverseInertiaTensorWorld(Mat3x3& InverseInertiaTensor) const
     {
-        InverseInertiaTensor = InverseInertiaTensorWorld;
+        InverseInertiaTensor = Store->InverseInertiaTensorWorld.Get(Slot).ToMatrix();
     }
 
     void Body::SetDamping(const float LinearDamping,
         const float AngularDamping)
     {
-        this->LinearDamping = LinearDamping;
-        this->AngularDamping = AngularDamping;
+        Store->LinearDamping[Slot] = LinearDamping;
+        Store->AngularDamping[Slot] = AngularDamping;
     }
 
     void Body::SetPosition(const Vec3& Position)
     {
-        this->Position = Position;
+        Store->Position.Set(Slot, Position);
     }
 
     void Body::SetPosition(const float x, const float y, const float z)
     {
-        Position.x = x;
-        Position.y = y;
-        Position.z = z;
+        Store->Position.Set(Slot, Vec3(x, y, z));
     }
 
     void Body::GetPosition(Vec3& Position) const
     {
-        Position = this->Position;
-    }
-
-    Vec3 Body::GetPosition() const
-    {
-        return Position;
+        Position = Store->Position.Get(Slot);
     }
 
     void Body::SetOrientation(const Quaternion& Orientation)
     {
-        this->Orientation = Orientation;
-        this->Orientation.Normalize();
+        SetOrientation(Orientation.w, Orientation.x, Orientation.y, Orientation.z);
     }
 
     void Body::SetOrientation(const float w, const float x, const float y, const float z)
     {
-        Orientation.w = w;
-        Orientation.x = x;
-        Orientation.y = y;
-        Orientation.z = z;
+        Quaternion Orientation(w, x, y, z);
         Orientation.Normalize();
+        Store->Orientation.Set(Slot, Orientation);
     }
 
     void Body::GetOrientation(Quaternion& Orientation) const
     {
-        Orientation = this->Orientation;
+        Orientation = Store->Orientation.Get(Slot);
     }
 
     void Body::GetOrientation(Mat3x3& matrix) const
@@ -226,75 +222,69 @@ namespace CrunchMath
 
     void Body::SetVelocity(const float x, const float y, const float z)
     {
-        Velocity.x = x;
-        Velocity.y = y;
-        Velocity.z = z;
-    }
-
-    Vec3 Body::GetVelocity() const
-    {
-        return Velocity;
-    }
-
-    void Body::AddVelocity(const Vec3& deltaVelocity)
-    {
-        Velocity += deltaVelocity;
+        Store->Velocity.Set(Slot, Vec3(x, y, z));
     }
 
     void Body::SetRotation(const float x, const float y, const float z)
     {
-        Rotation.x = x;
-        Rotation.y = y;
-        Rotation.z = z;
-    }
-
-    Vec3 Body::GetRotation() const
-    {
-        return Rotation;
-    }
-
-    void Body::AddRotation(const Vec3& deltaRotation)
-    {
-        Rotation += deltaRotation;
+        Store->Rotation.Set(Slot, Vec3(x, y, z));
     }
 
     void Body::SetAwake(const bool awake)
     {
         if (awake)
         {
-            IsAwake = true;
+            Store->IsAwake[Slot] = true;
 
             // Add a bit of Motion to avoid it falling asleep immediately.
-            Motion = SleepEpsilon * 2.0f;
+            Store->Motion[Slot] = SleepEpsilon * 2.0f;
         }
 
         else
         {
-            IsAwake = false;
-            Velocity = Vec3(0.0f, 0.0f, 0.0f);
-            Rotation = Vec3(0.0f, 0.0f, 0.0f);
+            Store->IsAwake[Slot] = false;
+            Store->Velocity.Set(Slot, Vec3(0.0f, 0.0f, 0.0f));
+            Store->Rotation.Set(Slot, Vec3(0.0f, 0.0f, 0.0f));
         }
     }
 
+    bool Body::GetCanSleep() const
+    {
+        return Store->CanSleep[Slot];
+    }
+
+    void Body::SetCanSleep(const bool canSleep)
+    {
+        Store->CanSleep[Slot] = canSleep;
+
+        if (!canSleep && !Store->IsAwake[Slot])
+            SetAwake();
+    }
+
+    float Body::GetMotion() const
+    {
+        return Store->Motion[Slot];
+    }
+
     Vec3 Body::GetLastFrameAcceleration() const
     {
-        return LastFrameAcceleration;
+        return Store->LastFrameAcceleration.Get(Slot);
     }
 
     void Body::ClearAccumulators()
     {
-        ForceAccumulation = Vec3(0.0f, 0.0f, 0.0f);
-        TorqueAccumulation = Vec3(0.0f, 0.0f, 0.0f);
+        Store->ForceAccumulation.Set(Slot, Vec3(0.0f, 0.0f, 0.0f));
+        Store->TorqueAccumulation.Set(Slot, Vec3(0.0f, 0.0f, 0.0f));
     }
 
     void Body::SetAcceleration(const Vec3& Acceleration)
     {
-        Body::Acceleration = Acceleration;
+        Store->Acceleration.Set(Slot, Acceleration);
     }
 
     bool Body::GetAwake() const
     {
-        return IsAwake;
+        return Store->IsAwake[Slot];
     }
 
     void Body::SetInertiaTensorCoeffs(float ix, float iy, float iz, float ixy, float ixz, float iyz)
@@ -315,23 +305,27 @@ namespace CrunchMath
 
     void Body::Copy(const Body& copybody)
     {
-        InverseMass = copybody.InverseMass;
+        BodyStore& From = *copybody.Store;
+        unsigned FromSlot = copybody.Slot;
+
+        Store->InverseMass[Slot] = From.InverseMass[FromSlot];
         InverseInertiaTensor = copybody.InverseInertiaTensor;
-        LinearDamping = copybody.LinearDamping;
-        AngularDamping = copybody.AngularDamping;
-        Position = copybody.Position;
-        Orientation = copybody.Orientation;
-        Velocity = copybody.Velocity;
-        Rotation = copybody.Rotation;
-        InverseInertiaTensorWorld = copybody.InverseInertiaTensorWorld;
-        Motion = copybody.Motion;
-        IsAwake = copybody.IsAwake;
-        CanSleep = copybody.CanSleep;
+        Store->LinearDamping[Slot] = From.LinearDamping[FromSlot];
+        Store->AngularDamping[Slot] = From.AngularDamping[FromSlot];
+        Store->Position.Set(Slot, From.Position.Get(FromSlot));
+        Store->Orientation.Set(Slot, From.Orientation.Get(FromSlot));
+        Store->Velocity.Set(Slot, From.Velocity.Get(FromSlot));
+        Store->Rotation.Set(Slot, From.Rotation.Get(FromSlot));
+        Store->InverseInertiaTensorWorld.Set(Slot, From.InverseInertiaTensorWorld.Get(FromSlot));
+        Store->Motion[Slot] = From.Motion[FromSlot];
+        Store->IsAwake[Slot] = From.IsAwake[FromSlot];
+        Store->CanSleep[Slot] = From.CanSleep[FromSlot];
         TransformMatrix = copybody.TransformMatrix;
-        ForceAccumulation = copybody.ForceAccumulation;
-        TorqueAccumulation = copybody.TorqueAccumulation;
-        Acceleration = copybody.Acceleration;
-        LastFrameAcceleration = copybody.LastFrameAcceleration;
+        Store->ForceAccumulation.Set(Slot, From.ForceAccumulation.Get(FromSlot));
+        Store->TorqueAccumulation.Set(Slot, From.TorqueAccumulation.Get(FromSlot));
+        Store->Acceleration.Set(Slot, From.Acceleration.Get(FromSlot));
+        Store->LastFrameAcceleration.Set(Slot, From.LastFrameAcceleration.Get(FromSlot));
         Primitive = copybody.Primitive;
+        Filter = copybody.Filter;
     }
 }
\ No newline at end of file
@@ -1,29 +1,61 @@
 #pragma once
 #include "../Math/Mat3x3.h"
 #include "../Math/Mat4x4.h"
+#include "BodyStore.h"
 
 namespace CrunchMath {
 
     class cmShape;
+
+    /* Decides which bodies may collide. Two bodies collide when the Category of each shares a bit
+     * with the Mask of the other. Bodies of the same nonzero Group skip that test, they always
+     * collide if the Group is positive and never if it is negative (a projectile and its owner).
+     */
+    struct CollisionFilter
+    {
+        unsigned Category = 1;
+        unsigned Mask = 0xffffffff;
+        int Group = 0;
+    };
+
+    inline bool ShouldCollide(const CollisionFilter& a, const CollisionFilter& b)
+    {
+        if (a.Group == b.Group && a.Group != 0)
+            return a.Group > 0;
+
+        return (a.Category & b.Mask) != 0 && (b.Category & a.Mask) != 0;
+    }
     
     class Body
     {
         friend class World;
+        friend class BroadPhase;
     public:
-        Body();
-        Body(const Body& copybody);
-        Body& operator=(const Body& copybody);
-        ~Body()
+        /* How a body takes part in the simulation. Dynamic bodies are moved by forces and contacts.
+         * Static bodies never move, kinematic bodies move at the Velocity and Rotation they are
+         * given. Neither is moved by contacts, they keep an infinite mass whatever SetMass is given.
+         */
+        enum BodyType
         {
-            if (Primitive != nullptr)
-                delete Primitive;
+            bt_Dynamic,
+            bt_Static,
+            bt_Kinematic
         };
 
+        Body();
+        //A Body is a view onto a slot of its World block's BodyStore, it can't be copied into a new one.
+        Body(const Body& copybody) = delete;
+        //Copies the state of copybody into this body's slot.
+        Body& operator=(const Body& copybody);
+
+        BodyType GetType() const { return Type; }
         void CalculateDerivedData();
         void Integrate(float duration);
         void SetMass(const float mass);
         float GetMass() const;
         float GetInverseMass() const;
+        //Returns false for bodies of infinite mass, which nothing can move.
+        bool HasFiniteMass() const;
         void SetInertiaTensor(const Mat3x3 &inertiaTensor);
         void GetInertiaTensorWorld(Mat3x3& inertiaTensor) const;
         void GetInverseInertiaTensorWorld(Mat3x3& InverseInertiaTensor) const;
@@ -47,10 +79,19 @@ namespace CrunchMath {
         void SetRotation(const float x, const float y, const float z);
         Vec3 GetRotation() const;
         void AddRotation(const Vec3 &deltaRotation);
+        //Returns the shape, pooled by the World and shared with every body of the same shape.
         const cmShape* GetShape() const { return Primitive; };
+        //Pairs of bodies whose filters don't let them collide are dropped before the narrow phase.
+        const CollisionFilter& GetCollisionFilter() const { return Filter; }
+        void SetCollisionFilter(const CollisionFilter& filter) { Filter = filter; }
 
         bool GetAwake() const;
         void SetAwake(const bool awake=true);
+        //A body that can't sleep is woken up and stays awake. Bodies created by a World can sleep.
+        bool GetCanSleep() const;
+        void SetCanSleep(const bool canSleep=true);
+        //Returns the recent average of the squared Velocity and Rotation, the body may sleep once it drops below SleepEpsilon.
+        float GetMotion() const;
  
         Vec3 GetLastFrameAcceleration() const;
         void ClearAccumulators();
@@ -62,35 +103,34 @@ namespace CrunchMath {
     private:
         void Copy(const Body& copybody);
 
-        float InverseMass;
-        Mat3x3 InverseInertiaTensor;
-
-        float LinearDamping;
-        float AngularDamping;
+        //Makes this body the view onto the given slot, and resets the body and that slot.
+        void Bind(BodyStore* store, unsigned slot);
 
-        Vec3 Position;
-        Quaternion Orientation;
-		Vec3 Size;
+        //Updates the matrices from the Position and the (normalized) Orientation.
+        void CalculateTransform();
 
-        Vec3 Velocity;
-        Vec3 Rotation;
+        //Holds the state Integrate works on, Position, Velocity, mass, etc.
+        BodyStore* Store = nullptr;
+        unsigned Slot = 0;
 
-        Mat3x3 InverseInertiaTensorWorld;
+        //Holds the inverse of the inertia tensor in body space.
+        SymmetricTensor InverseInertiaTensor = {};
 
-        float Motion;
-        bool IsAwake;
-        bool CanSleep;
+		Vec3 Size;
 
         Mat4x4 TransformMatrix;
 
-        Vec3 ForceAccumulation;
-        Vec3 TorqueAccumulation;
+		const cmShape* Primitive = nullptr;
+
+        CollisionFilter Filter;
+
+        BodyType Type = bt_Dynamic;
 
-        Vec3 Acceleration;
-        Vec3 LastFrameAcceleration;
+        //Index of this body's slot in the World
+        unsigned Id = 0xffffffff;
 
-		Body* m_pNext;
-		cmShape* Primitive = nullptr;
+        //Index of this body's proxy in the World's BroadPhase
+        unsigned ProxyId = 0xffffffff;
     };
 
     /*
@@ -104,4 +144,42 @@ namespace CrunchMath {
       Defined in Body.cpp***
     */
     extern float SleepEpsilon;
+
+    // The accessors the contact resolvers call for every contact are
+    // inline, so a Vec3 doesn't have to cross a call to get to them.
+
+    inline float Body::GetInverseMass() const
+    {
+        return Store->InverseMass[Slot];
+    }
+
+    inline bool Body::HasFiniteMass() const
+    {
+        return Store->InverseMass[Slot] > 0.0f;
+    }
+
+    inline Vec3 Body::GetPosition() const
+    {
+        return Store->Position.Get(Slot);
+    }
+
+    inline Vec3 Body::GetVelocity() const
+    {
+        return Store->Velocity.Get(Slot);
+    }
+
+    inline void Body::AddVelocity(const Vec3& deltaVelocity)
+    {
+        Store->Velocity.Set(Slot, Store->Velocity.Get(Slot) + deltaVelocity);
+    }
+
+    inline Vec3 Body::GetRotation() const
+    {
+        return Store->Rotation.Get(Slot);
+    }
+
+    inline void Body::AddRotation(const Vec3& deltaRotation)
+    {
+        Store->Rotation.Set(Slot, Store->Rotation.Get(Slot) + deltaRotation);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,223 @@
+#include "BodyStore.h"
+#include "Body.h"
+
+namespace CrunchMath {
+
+#ifdef CM_SIMD_SSE
+    // Writes Value over the lanes of Array where Awake is set and leaves the others.
+    static inline void StoreAwake(float* Array, __m128 Awake, __m128 Value)
+    {
+        _mm_storeu_ps(Array, _mm_or_ps(_mm_and_ps(Awake, Value), _mm_andnot_ps(Awake, _mm_loadu_ps(Array))));
+    }
+#endif
+
+    BodyStore::BodyStore()
+    {
+        for (unsigned i = 0; i < Capacity; i++)
+            Reset(i);
+    }
+
+    void BodyStore::Reset(unsigned Slot)
+    {
+        Position.Set(Slot, Vec3(0.0f, 0.0f, 0.0f));
+        Orientation.Set(Slot, Quaternion(1.0f, 0.0f, 0.0f, 0.0f));
+        Velocity.Set(Slot, Vec3(0.0f, 0.0f, 0.0f));
+        Rotation.Set(Slot, Vec3(0.0f, 0.0f, 0.0f));
+        Acceleration.Set(Slot, Vec3(0.0f, 0.0f, 0.0f));
+        LastFrameAcceleration.Set(Slot, Vec3(0.0f, 0.0f, 0.0f));
+        ForceAccumulation.Set(Slot, Vec3(0.0f, 0.0f, 0.0f));
+        TorqueAccumulation.Set(Slot, Vec3(0.0f, 0.0f, 0.0f));
+
+        InverseMass[Slot] = 0.0f;
+        LinearDamping[Slot] = 0.9f;
+        AngularDamping[Slot] = 0.9f;
+        Motion[Slot] = 0.0f;
+
+        InverseInertiaTensorWorld.Set(Slot, SymmetricTensor{ 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f });
+
+        IsAwake[Slot] = false;
+        CanSleep[Slot] = false;
+        Integrated[Slot] = false;
+    }
+
+    void BodyStore::Integrate(float duration, unsigned Begin, unsigned End)
+    {
+#ifdef CM_SIMD_SSE
+        const __m128 Zero = _mm_setzero_ps();
+        const __m128 Half = _mm_set1_ps(0.5f);
+        const __m128 Duration = _mm_set1_ps(duration);
+
+        for (; Begin + Lanes <= End; Begin += Lanes)
+        {
+            const unsigned i = Begin;
+
+            // Sleeping bodies are carried through unchanged, by blending the
+            // old values back in wherever Awake is clear.
+            __m128 Awake = _mm_castsi128_ps(_mm_set_epi32(-(int)IsAwake[i + 3], -(int)IsAwake[i + 2],
+                                                          -(int)IsAwake[i + 1], -(int)IsAwake[i]));
+            int AwakeBits = _mm_movemask_ps(Awake);
+            for (unsigned Lane = 0; Lane < Lanes; Lane++)
+                Integrated[i + Lane] = (AwakeBits >> Lane) & 1;
+
+            if (AwakeBits == 0)
+                continue;
+
+            // There is no packed pow, the drag factors are worked out one by one.
+            alignas(16) float LinearDrag[Lanes];
+            alignas(16) float AngularDrag[Lanes];
+            for (unsigned Lane = 0; Lane < Lanes; Lane++)
+            {
+                LinearDrag[Lane] = powf(LinearDamping[i + Lane], duration);
+                AngularDrag[Lane] = powf(AngularDamping[i + Lane], duration);
+            }
+
+            // Calculate linear Acceleration from force inputs.
+            __m128 InvMass = _mm_loadu_ps(InverseMass + i);
+            __m128 Ax = _mm_add_ps(_mm_loadu_ps(Acceleration.x + i), _mm_mul_ps(_mm_loadu_ps(ForceAccumulation.x + i), InvMass));
+            __m128 Ay = _mm_add_ps(_mm_loadu_ps(Acceleration.y + i), _mm_mul_ps(_mm_loadu_ps(ForceAccumulation.y + i), InvMass));
+            __m128 Az = _mm_add_ps(_mm_loadu_ps(Acceleration.z + i), _mm_mul_ps(_mm_loadu_ps(ForceAccumulation.z + i), InvMass));
+
+            // Calculate angular Acceleration from torque inputs.
+            __m128 Tx = _mm_loadu_ps(TorqueAccumulation.x + i);
+            __m128 Ty = _mm_loadu_ps(TorqueAccumulation.y + i);
+            __m128 Tz = _mm_loadu_ps(TorqueAccumulation.z + i);
+            const SymmetricTensorArray& I = InverseInertiaTensorWorld;
+            __m128 Ixy = _mm_loadu_ps(I.XY + i);
+            __m128 Ixz = _mm_loadu_ps(I.XZ + i);
+            __m128 Iyz = _mm_loadu_ps(I.YZ + i);
+            __m128 AngAx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(I.XX + i), Tx), _mm_mul_ps(Ixy, Ty)), _mm_mul_ps(Ixz, Tz));
+            __m128 AngAy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(Ixy, Tx), _mm_mul_ps(_mm_loadu_ps(I.YY + i), Ty)), _mm_mul_ps(Iyz, Tz));
+            __m128 AngAz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(Ixz, Tx), _mm_mul_ps(Iyz, Ty)), _mm_mul_ps(_mm_loadu_ps(I.ZZ + i), Tz));
+
+            // Update linear and angular Velocity and impose drag.
+            __m128 LinDrag = _mm_load_ps(LinearDrag);
+            __m128 AngDrag = _mm_load_ps(AngularDrag);
+            __m128 Vx = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(Velocity.x + i), _mm_mul_ps(Ax, Duration)), LinDrag);
+            __m128 Vy = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(Velocity.y + i), _mm_mul_ps(Ay, Duration)), LinDrag);
+            __m128 Vz = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(Velocity.z + i), _mm_mul_ps(Az, Duration)), LinDrag);
+            __m128 Rx = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(Rotation.x + i), _mm_mul_ps(AngAx, Duration)), AngDrag);
+            __m128 Ry = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(Rotation.y + i), _mm_mul_ps(AngAy, Duration)), AngDrag);
+            __m128 Rz = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(Rotation.z + i), _mm_mul_ps(AngAz, Duration)), AngDrag);
+
+            // Update linear Position.
+            __m128 Px = _mm_add_ps(_mm_loadu_ps(Position.x + i), _mm_mul_ps(Vx, Duration));
+            __m128 Py = _mm_add_ps(_mm_loadu_ps(Position.y + i), _mm_mul_ps(Vy, Duration));
+            __m128 Pz = _mm_add_ps(_mm_loadu_ps(Position.z + i), _mm_mul_ps(Vz, Duration));
+
+            // Update angular Position, Orientation += 0.5 * (0, Rotation * duration) * Orientation.
+            // Terms are summed in the order Quaternion::operator* sums them.
+            __m128 Ow = _mm_loadu_ps(Orientation.w + i);
+            __m128 Ox = _mm_loadu_ps(Orientation.x + i);
+            __m128 Oy = _mm_loadu_ps(Orientation.y + i);
+            __m128 Oz = _mm_loadu_ps(Orientation.z + i);
+            __m128 Sx = _mm_mul_ps(Rx, Duration);
+            __m128 Sy = _mm_mul_ps(Ry, Duration);
+            __m128 Sz = _mm_mul_ps(Rz, Duration);
+            __m128 Qw = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_mul_ps(Zero, Ow), _mm_mul_ps(Sx, Ox)), _mm_mul_ps(Sy, Oy)), _mm_mul_ps(Sz, Oz));
+            __m128 Qx = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(Zero, Ox), _mm_mul_ps(Sx, Ow)), _mm_mul_ps(Sz, Oy)), _mm_mul_ps(Sy, Oz));
+            __m128 Qy = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(Zero, Oy), _mm_mul_ps(Sy, Ow)), _mm_mul_ps(Sx, Oz)), _mm_mul_ps(Sz, Ox));
+            __m128 Qz = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(Zero, Oz), _mm_mul_ps(Sz, Ow)), _mm_mul_ps(Sy, Ox)), _mm_mul_ps(Sx, Oy));
+            Ow = _mm_add_ps(Ow, _mm_mul_ps(Qw, Half));
+            Ox = _mm_add_ps(Ox, _mm_mul_ps(Qx, Half));
+            Oy = _mm_add_ps(Oy, _mm_mul_ps(Qy, Half));
+            Oz = _mm_add_ps(Oz, _mm_mul_ps(Qz, Half));
+
+            StoreAwake(LastFrameAcceleration.x + i, Awake, Ax);
+            StoreAwake(LastFrameAcceleration.y + i, Awake, Ay);
+            StoreAwake(LastFrameAcceleration.z + i, Awake, Az);
+            StoreAwake(Velocity.x + i, Awake, Vx);
+            StoreAwake(Velocity.y + i, Awake, Vy);
+            StoreAwake(Velocity.z + i, Awake, Vz);
+            StoreAwake(Rotation.x + i, Awake, Rx);
+            StoreAwake(Rotation.y + i, Awake, Ry);
+            StoreAwake(Rotation.z + i, Awake, Rz);
+            StoreAwake(Position.x + i, Awake, Px);
+            StoreAwake(Position.y + i, Awake, Py);
+            StoreAwake(Position.z + i, Awake, Pz);
+            StoreAwake(Orientation.w + i, Awake, Ow);
+            StoreAwake(Orientation.x + i, Awake, Ox);
+            StoreAwake(Orientation.y + i, Awake, Oy);
+            StoreAwake(Orientation.z + i, Awake, Oz);
+
+            // Clear accumulators.
+            StoreAwake(ForceAccumulation.x + i, Awake, Zero);
+            StoreAwake(ForceAccumulation.y + i, Awake, Zero);
+            StoreAwake(ForceAccumulation.z + i, Awake, Zero);
+            StoreAwake(TorqueAccumulation.x + i, Awake, Zero);
+            StoreAwake(TorqueAccumulation.y + i, Awake, Zero);
+            StoreAwake(TorqueAccumulation.z + i, Awake, Zero);
+
+            for (unsigned Lane = 0; Lane < Lanes; Lane++)
+            {
+                if (Integrated[i + Lane])
+                    UpdateMotion(duration, i + Lane);
+            }
+        }
+#endif
+        // Whatever is left over, or everything without SSE.
+        IntegrateScalar(duration, Begin, End);
+    }
+
+    void BodyStore::IntegrateScalar(float duration, unsigned Begin, unsigned End)
+    {
+        for (unsigned i = Begin; i < End; i++)
+        {
+            Integrated[i] = IsAwake[i];
+            if (!IsAwake[i])
+                continue;
+
+            // Calculate linear Acceleration from force inputs.
+            Vec3 LastFrameAcc = Acceleration.Get(i);
+            LastFrameAcc += ForceAccumulation.Get(i) * InverseMass[i];
+            LastFrameAcceleration.Set(i, LastFrameAcc);
+
+            // Calculate angular Acceleration from torque inputs.
+            Vec3 angularAcceleration = InverseInertiaTensorWorld.Get(i).ToMatrix() * TorqueAccumulation.Get(i);
+
+            // Update linear and angular Velocity, and impose drag.
+            Vec3 Vel = Velocity.Get(i);
+            Vec3 Rot = Rotation.Get(i);
+            Vel += LastFrameAcc * duration;
+            Rot += angularAcceleration * duration;
+            Vel *= powf(LinearDamping[i], duration);
+            Rot *= powf(AngularDamping[i], duration);
+            Velocity.Set(i, Vel);
+            Rotation.Set(i, Rot);
+
+            // Update linear Position.
+            Vec3 Pos = Position.Get(i);
+            Pos += Vel * duration;
+            Position.Set(i, Pos);
+
+            // Update angular Position.
+            Quaternion Orient = Orientation.Get(i);
+            Quaternion q(0, Vec3(Rot * duration));
+            q *= Orient;
+            Orient += q * ((float)0.5);
+            Orientation.Set(i, Orient);
+
+            // Clear accumulators.
+            ForceAccumulation.Set(i, Vec3(0.0f, 0.0f, 0.0f));
+            TorqueAccumulation.Set(i, Vec3(0.0f, 0.0f, 0.0f));
+
+            UpdateMotion(duration, i);
+        }
+    }
+
+    void BodyStore::UpdateMotion(float duration, unsigned Slot)
+    {
+        // Update the kinetic energy store. Whether the body goes to sleep
+        // is left to the World, which knows what it is touching.
+        if (!CanSleep[Slot])
+            return;
+
+        Vec3 Vel = Velocity.Get(Slot);
+        Vec3 Rot = Rotation.Get(Slot);
+        float currentMotion = DotProduct(Vel, Vel) + DotProduct(Rot, Rot);
+
+        float bias = powf(0.5, duration);
+        Motion[Slot] = bias * Motion[Slot] + (1 - bias) * currentMotion;
+
+        if (Motion[Slot] > 10 * SleepEpsilon) Motion[Slot] = 10 * SleepEpsilon;
+    }
+}
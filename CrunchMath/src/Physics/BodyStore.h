@@ -0,0 +1,144 @@
+#pragma once
+#include "../Math/Mat3x3.h"
+
+namespace CrunchMath {
+
+    /**
+     * A symmetric 3x3 tensor, such as an inertia tensor, by its six
+     * distinct elements: the diagonal and the three elements above it.
+     */
+    struct SymmetricTensor
+    {
+        float XX, YY, ZZ;
+        float XY, XZ, YZ;
+
+        Mat3x3 ToMatrix() const
+        {
+            return Mat3x3(Vec3(XX, XY, XZ), Vec3(XY, YY, YZ), Vec3(XZ, YZ, ZZ));
+        }
+
+        /** Takes the diagonal and the elements above it, the rest is assumed to match. */
+        static SymmetricTensor FromMatrix(const Mat3x3& m)
+        {
+            return SymmetricTensor{ m.Matrix[0][0], m.Matrix[1][1], m.Matrix[2][2],
+                                    m.Matrix[1][0], m.Matrix[2][0], m.Matrix[2][1] };
+        }
+
+        bool IsDiagonal() const
+        {
+            return XY == 0.0f && XZ == 0.0f && YZ == 0.0f;
+        }
+    };
+
+    /**
+     * Holds the state of a block of bodies, one contiguous array per
+     * quantity (a structure of arrays) instead of one record per body.
+     * That way Integrate can load the same quantity of several bodies
+     * with a single SIMD instruction and advance them all at once.
+     *
+     * Bodies are views onto a slot of a store, the World binds each body
+     * of a block to the slot of the same index. The store only holds what
+     * Integrate works on, the rest of a body stays in the Body itself.
+     */
+    class BodyStore
+    {
+        friend class Body;
+    public:
+        /**
+         * Holds the number of bodies advanced together by one instruction
+         * of Integrate.
+         */
+        const static unsigned Lanes = 4;
+
+        /**
+         * Holds the number of slots, a whole number of groups of 8 so
+         * wider kernels fit too.
+         */
+        const static unsigned Capacity = 128;
+
+        BodyStore();
+
+        /**
+         * Puts the slot back to the state of a fresh body: at rest at the
+         * origin, asleep, with no mass properties.
+         */
+        void Reset(unsigned Slot);
+
+        /**
+         * Integrates the awake bodies in the slots [Begin, End) forward in
+         * time by the given duration, Lanes bodies at a time where SSE is
+         * available. The orientations come out unnormalized and the derived
+         * data is left alone, Body::CalculateDerivedData has to be called on
+         * every slot WasIntegrated tells.
+         */
+        void Integrate(float duration, unsigned Begin, unsigned End);
+
+        /** Returns whether the slot was awake on the last call to Integrate. */
+        bool WasIntegrated(unsigned Slot) const { return Integrated[Slot]; }
+
+    private:
+        struct Vec3Array
+        {
+            alignas(16) float x[Capacity];
+            alignas(16) float y[Capacity];
+            alignas(16) float z[Capacity];
+
+            Vec3 Get(unsigned Slot) const { return Vec3(x[Slot], y[Slot], z[Slot]); }
+            void Set(unsigned Slot, const Vec3& v) { x[Slot] = v.x; y[Slot] = v.y; z[Slot] = v.z; }
+        };
+
+        struct QuaternionArray
+        {
+            alignas(16) float w[Capacity];
+            alignas(16) float x[Capacity];
+            alignas(16) float y[Capacity];
+            alignas(16) float z[Capacity];
+
+            Quaternion Get(unsigned Slot) const { return Quaternion(w[Slot], x[Slot], y[Slot], z[Slot]); }
+            void Set(unsigned Slot, const Quaternion& q) { w[Slot] = q.w; x[Slot] = q.x; y[Slot] = q.y; z[Slot] = q.z; }
+        };
+
+        struct SymmetricTensorArray
+        {
+            alignas(16) float XX[Capacity];
+            alignas(16) float YY[Capacity];
+            alignas(16) float ZZ[Capacity];
+            alignas(16) float XY[Capacity];
+            alignas(16) float XZ[Capacity];
+            alignas(16) float YZ[Capacity];
+
+            SymmetricTensor Get(unsigned Slot) const { return SymmetricTensor{ XX[Slot], YY[Slot], ZZ[Slot], XY[Slot], XZ[Slot], YZ[Slot] }; }
+            void Set(unsigned Slot, const SymmetricTensor& t) { XX[Slot] = t.XX; YY[Slot] = t.YY; ZZ[Slot] = t.ZZ; XY[Slot] = t.XY; XZ[Slot] = t.XZ; YZ[Slot] = t.YZ; }
+        };
+
+        /** Integrates the slots [Begin, End) one at a time. */
+        void IntegrateScalar(float duration, unsigned Begin, unsigned End);
+
+        /** Updates the Motion of an integrated slot, the World decides whether it sleeps. */
+        void UpdateMotion(float duration, unsigned Slot);
+
+        Vec3Array Position;
+        QuaternionArray Orientation;
+
+        Vec3Array Velocity;
+        Vec3Array Rotation;
+
+        Vec3Array Acceleration;
+        Vec3Array LastFrameAcceleration;
+
+        Vec3Array ForceAccumulation;
+        Vec3Array TorqueAccumulation;
+
+        alignas(16) float InverseMass[Capacity];
+        alignas(16) float LinearDamping[Capacity];
+        alignas(16) float AngularDamping[Capacity];
+        alignas(16) float Motion[Capacity];
+
+        /** Holds the world space inverse inertia tensors, which are symmetric. */
+        SymmetricTensorArray InverseInertiaTensorWorld;
+
+        bool IsAwake[Capacity];
+        bool CanSleep[Capacity];
+        bool Integrated[Capacity];
+    };
+}
@@ -0,0 +1,735 @@
+#include <float.h>
+#include <assert.h>
+#include "BroadPhase.h"
+
+namespace CrunchMath {
+
+    BroadPhase::BroadPhase()
+    {
+        BroadPhaseType = bp_DynamicTree;
+        Margin = 0.02f;
+        CellSize = 0.1f;
+    }
+
+    void BroadPhase::CalculateVolume(const Body& body, AABB& Volume)
+    {
+        const Mat4x4& Transform = body.GetTransform();
+        Vec3 Center = GetTranslation(Transform);
+        Vec3 Extent;
+
+        switch (body.GetShape()->GetType())
+        {
+        case cmShape::Type::s_Box: {
+            // Project the rotated half sizes onto each world axis.
+            const Vec3& HalfSize = static_cast<const cmBox*>(body.GetShape())->GetHalfSizes();
+            for (unsigned i = 0; i < 3; i++)
+            {
+                Extent[i] = HalfSize.x * fabsf(Transform.Matrix[0][i]) +
+                            HalfSize.y * fabsf(Transform.Matrix[1][i]) +
+                            HalfSize.z * fabsf(Transform.Matrix[2][i]);
+            }
+            break;
+        }
+
+        case cmShape::Type::s_Sphere: {
+            float Radius = static_cast<const cmSphere*>(body.GetShape())->GetRadius();
+            Extent = Vec3(Radius, Radius, Radius);
+            break;
+        }
+
+        default:
+            assert(false);
+            break;
+        }
+
+        Volume.Set(Center - Extent, Center + Extent);
+    }
+
+    bool BroadPhase::ShouldPair(const Body& One, const Body& Two)
+    {
+        if (One.GetType() != Body::bt_Dynamic && Two.GetType() != Body::bt_Dynamic)
+            return false;
+
+        return ShouldCollide(One.GetCollisionFilter(), Two.GetCollisionFilter());
+    }
+
+    void BroadPhase::SetType(Type type)
+    {
+        if (type == BroadPhaseType)
+            return;
+
+        // Tear down the structure of the old type...
+        if (BroadPhaseType == bp_DynamicTree)
+        {
+            for (unsigned i = 0; i < Proxies.size(); i++)
+            {
+                Tree.Remove(Proxies[i].Leaf);
+                Proxies[i].Leaf = nullptr;
+            }
+        }
+
+        else if (BroadPhaseType == bp_SweepAndPrune)
+        {
+            for (unsigned axis = 0; axis < 3; axis++)
+                Axes[axis].clear();
+
+            for (unsigned i = 0; i < Partners.size(); i++)
+                Partners[i].clear();
+        }
+
+        else if (BroadPhaseType == bp_SpatialHash)
+        {
+            BucketStart.clear();
+            GridEntries.clear();
+            LargeProxies.clear();
+        }
+
+        // ...and register every proxy with the new one.
+        BroadPhaseType = type;
+        for (unsigned i = 0; i < Proxies.size(); i++)
+        {
+            if (BroadPhaseType == bp_DynamicTree)
+                InsertLeaf(i);
+
+            else if (BroadPhaseType == bp_SweepAndPrune)
+                InsertEndPoints(i);
+        }
+    }
+
+    BroadPhase::Type BroadPhase::GetType() const
+    {
+        return BroadPhaseType;
+    }
+
+    void BroadPhase::Insert(Body* body)
+    {
+        // Bodies are usually placed after they have been created, so the
+        // volume of a static body is only worked out on the next Update.
+        if (body->GetType() == Body::bt_Static)
+        {
+            StaticProxy proxy;
+            proxy.Object = body;
+            proxy.Leaf = nullptr;
+
+            body->ProxyId = (unsigned)StaticProxies.size();
+            StaticProxies.push_back(proxy);
+            StaticsMoved = true;
+            return;
+        }
+
+        Proxy proxy;
+        proxy.Object = body;
+        proxy.Leaf = nullptr;
+
+        body->ProxyId = (unsigned)Proxies.size();
+        Proxies.push_back(proxy);
+
+        if (BroadPhaseType == bp_DynamicTree)
+            InsertLeaf(body->ProxyId);
+
+        else if (BroadPhaseType == bp_SweepAndPrune)
+            InsertEndPoints(body->ProxyId);
+    }
+
+    void BroadPhase::Remove(Body* body)
+    {
+        if (body->GetType() == Body::bt_Static)
+        {
+            unsigned ProxyId = body->ProxyId;
+            assert(ProxyId < StaticProxies.size() && StaticProxies[ProxyId].Object == body);
+
+            if (StaticProxies[ProxyId].Leaf != nullptr)
+                StaticTree.Remove(StaticProxies[ProxyId].Leaf);
+
+            StaticProxies[ProxyId] = StaticProxies.back();
+            StaticProxies[ProxyId].Object->ProxyId = ProxyId;
+            StaticProxies.pop_back();
+            body->ProxyId = 0xffffffff;
+            return;
+        }
+
+        unsigned ProxyId = body->ProxyId;
+        unsigned Last = (unsigned)Proxies.size() - 1;
+        assert(ProxyId <= Last && Proxies[ProxyId].Object == body);
+
+        if (BroadPhaseType == bp_DynamicTree)
+            Tree.Remove(Proxies[ProxyId].Leaf);
+
+        else if (BroadPhaseType == bp_SweepAndPrune)
+        {
+            RemoveEndPoints(ProxyId);
+            if (ProxyId != Last)
+                RenameEndPoints(Last, ProxyId);
+        }
+
+        // The grid of bp_SpatialHash is rebuilt from the proxies on every
+        // Update, there is nothing to take out of it.
+
+        Proxies[ProxyId] = Proxies[Last];
+        Proxies[ProxyId].Object->ProxyId = ProxyId;
+        Proxies.pop_back();
+        body->ProxyId = 0xffffffff;
+    }
+
+    void BroadPhase::UpdateStatic(Body* body)
+    {
+        assert(body->GetType() == Body::bt_Static && StaticProxies[body->ProxyId].Object == body);
+
+        StaticProxy& proxy = StaticProxies[body->ProxyId];
+        if (proxy.Leaf != nullptr)
+        {
+            StaticTree.Remove(proxy.Leaf);
+            proxy.Leaf = nullptr;
+        }
+
+        StaticsMoved = true;
+    }
+
+    void BroadPhase::PlaceStatics()
+    {
+        for (unsigned i = 0; i < StaticProxies.size(); i++)
+        {
+            StaticProxy& proxy = StaticProxies[i];
+            if (proxy.Leaf != nullptr)
+                continue;
+
+            // Static bodies don't move, their volumes need no margin.
+            AABB Volume;
+            CalculateVolume(*proxy.Object, Volume);
+            proxy.Leaf = StaticTree.Insert(proxy.Object, Volume);
+        }
+
+        StaticsMoved = false;
+    }
+
+    void BroadPhase::InsertLeaf(unsigned ProxyId)
+    {
+        Proxy& proxy = Proxies[ProxyId];
+
+        AABB Volume;
+        CalculateVolume(*proxy.Object, Volume);
+        Volume.Enlarge(Margin);
+
+        proxy.Leaf = Tree.Insert(proxy.Object, Volume);
+    }
+
+    void BroadPhase::InsertEndPoints(unsigned ProxyId)
+    {
+        Proxy& proxy = Proxies[ProxyId];
+
+        if (Partners.size() <= ProxyId)
+            Partners.resize(ProxyId + 1);
+
+        // The new endpoints start out at the far end of every axis, where
+        // they can't overlap anything. The next Update sorts them into place
+        // and picks up their pairs on the way.
+        for (unsigned axis = 0; axis < 3; axis++)
+        {
+            proxy.Volume.Min[axis] = FLT_MAX;
+            proxy.Volume.Max[axis] = FLT_MAX;
+
+            EndPoint Min = { FLT_MAX, ProxyId << 1 };
+            EndPoint Max = { FLT_MAX, (ProxyId << 1) | 1 };
+
+            proxy.EndPoint[axis][0] = (unsigned)Axes[axis].size();
+            Axes[axis].push_back(Min);
+            proxy.EndPoint[axis][1] = (unsigned)Axes[axis].size();
+            Axes[axis].push_back(Max);
+        }
+    }
+
+    void BroadPhase::RemoveEndPoints(unsigned ProxyId)
+    {
+        const Proxy& proxy = Proxies[ProxyId];
+        for (unsigned axis = 0; axis < 3; axis++)
+        {
+            Axes[axis][proxy.EndPoint[axis][0]].Data = DeadEndPoint;
+            Axes[axis][proxy.EndPoint[axis][1]].Data = DeadEndPoint;
+        }
+
+        std::vector<unsigned>& Removed = Partners[ProxyId];
+        for (unsigned i = 0; i < Removed.size(); i++)
+            RemovePartner(Partners[Removed[i]], ProxyId);
+
+        Removed.clear();
+    }
+
+    void BroadPhase::RenameEndPoints(unsigned From, unsigned To)
+    {
+        const Proxy& proxy = Proxies[From];
+        for (unsigned axis = 0; axis < 3; axis++)
+        {
+            Axes[axis][proxy.EndPoint[axis][0]].Data = To << 1;
+            Axes[axis][proxy.EndPoint[axis][1]].Data = (To << 1) | 1;
+        }
+
+        // The list of To is empty, it was just removed. Swapping keeps the
+        // memory of both lists around.
+        std::vector<unsigned>& Renamed = Partners[From];
+        for (unsigned i = 0; i < Renamed.size(); i++)
+        {
+            std::vector<unsigned>& OtherPartners = Partners[Renamed[i]];
+            for (unsigned k = 0; k < OtherPartners.size(); k++)
+            {
+                if (OtherPartners[k] == From)
+                {
+                    OtherPartners[k] = To;
+                    break;
+                }
+            }
+        }
+
+        Partners[To].swap(Renamed);
+    }
+
+    void BroadPhase::AddPair(unsigned ProxyOne, unsigned ProxyTwo)
+    {
+        // A pair is in both lists, so the shorter one tells whether it is
+        // already there.
+        const std::vector<unsigned>& Shorter = (Partners[ProxyOne].size() <= Partners[ProxyTwo].size()) ? Partners[ProxyOne] : Partners[ProxyTwo];
+        unsigned Other = (&Shorter == &Partners[ProxyOne]) ? ProxyTwo : ProxyOne;
+        for (unsigned i = 0; i < Shorter.size(); i++)
+        {
+            if (Shorter[i] == Other)
+                return;
+        }
+
+        Partners[ProxyOne].push_back(ProxyTwo);
+        Partners[ProxyTwo].push_back(ProxyOne);
+    }
+
+    void BroadPhase::RemovePair(unsigned ProxyOne, unsigned ProxyTwo)
+    {
+        if (RemovePartner(Partners[ProxyOne], ProxyTwo))
+            RemovePartner(Partners[ProxyTwo], ProxyOne);
+    }
+
+    bool BroadPhase::RemovePartner(std::vector<unsigned>& List, unsigned ProxyId)
+    {
+        for (unsigned i = 0; i < List.size(); i++)
+        {
+            if (List[i] == ProxyId)
+            {
+                List[i] = List.back();
+                List.pop_back();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void BroadPhase::Update()
+    {
+        if (StaticsMoved)
+            PlaceStatics();
+
+        switch (BroadPhaseType)
+        {
+        case bp_DynamicTree: {
+            for (unsigned i = 0; i < Proxies.size(); i++)
+            {
+                AABB Volume;
+                CalculateVolume(*Proxies[i].Object, Volume);
+
+                AABB FatVolume = Volume;
+                FatVolume.Enlarge(Margin);
+
+                Tree.Update(Proxies[i].Leaf, Volume, FatVolume);
+            }
+            break;
+        }
+
+        case bp_SweepAndPrune: {
+            // Move every endpoint to its new value first, so that pairs are
+            // only ever judged on the final volumes while sorting.
+            for (unsigned i = 0; i < Proxies.size(); i++)
+            {
+                Proxy& proxy = Proxies[i];
+                CalculateVolume(*proxy.Object, proxy.Volume);
+                proxy.Volume.Enlarge(Margin);
+
+                for (unsigned axis = 0; axis < 3; axis++)
+                {
+                    Axes[axis][proxy.EndPoint[axis][0]].Value = proxy.Volume.Min[axis];
+                    Axes[axis][proxy.EndPoint[axis][1]].Value = proxy.Volume.Max[axis];
+                }
+            }
+
+            for (unsigned axis = 0; axis < 3; axis++)
+                SortAxis(axis);
+            break;
+        }
+
+        case bp_SpatialHash: {
+            BuildGrid();
+            break;
+        }
+
+        default:
+            break;
+        }
+    }
+
+    void BroadPhase::SortAxis(unsigned axis)
+    {
+        std::vector<EndPoint>& Axis = Axes[axis];
+
+        // Count is the end of the sorted part. Dead endpoints are left out
+        // of it, so the live ones close up over them as they are sorted.
+        unsigned Count = 0;
+        for (unsigned j = 0; j < Axis.size(); j++)
+        {
+            EndPoint Key = Axis[j];
+            if (Key.Data == DeadEndPoint)
+                continue;
+
+            unsigned KeyProxy = Key.Data >> 1;
+            bool KeyIsMax = (Key.Data & 1) != 0;
+
+            // On equal values mins go before maxes, so that touching volumes
+            // count as overlapping just like in AABB::BroadPhaseCollisionTest.
+            unsigned i = Count++;
+            while (i > 0 && (Axis[i - 1].Value > Key.Value ||
+                  (Axis[i - 1].Value == Key.Value && !KeyIsMax && (Axis[i - 1].Data & 1))))
+            {
+                EndPoint& Swapped = Axis[i - 1];
+                unsigned SwappedProxy = Swapped.Data >> 1;
+                bool SwappedIsMax = (Swapped.Data & 1) != 0;
+
+                if (!KeyIsMax && SwappedIsMax)
+                {
+                    // A min moved below another max, the volumes may have
+                    // started overlapping.
+                    if (Proxies[KeyProxy].Volume.BroadPhaseCollisionTest(Proxies[SwappedProxy].Volume))
+                        AddPair(KeyProxy, SwappedProxy);
+                }
+
+                else if (KeyIsMax && !SwappedIsMax)
+                {
+                    // A max moved below another min, the volumes are now
+                    // apart on this axis.
+                    RemovePair(KeyProxy, SwappedProxy);
+                }
+
+                Axis[i] = Swapped;
+                Proxies[SwappedProxy].EndPoint[axis][SwappedIsMax ? 1 : 0] = i;
+                i--;
+            }
+
+            if (i != j)
+            {
+                Axis[i] = Key;
+                Proxies[KeyProxy].EndPoint[axis][KeyIsMax ? 1 : 0] = i;
+            }
+        }
+
+        Axis.resize(Count);
+    }
+
+    int BroadPhase::GetCell(float Coordinate)
+    {
+        // Far enough in that High - Low + 1 can't overflow either. The
+        // negated test also sends a NaN to the low end.
+        const float Limit = 1073741824.0f;
+        if (!(Coordinate > -Limit))
+            return -(int)Limit;
+
+        if (Coordinate >= Limit)
+            return (int)Limit;
+
+        return (int)floorf(Coordinate);
+    }
+
+    unsigned BroadPhase::GetCellRange(const AABB& Volume, int Low[3], int High[3]) const
+    {
+        float InverseCellSize = 1.0f / CellSize;
+        for (unsigned axis = 0; axis < 3; axis++)
+        {
+            Low[axis] = GetCell(Volume.Min[axis] * InverseCellSize);
+            High[axis] = GetCell(Volume.Max[axis] * InverseCellSize);
+        }
+
+        // Each span is checked on its own before it is multiplied in, so the
+        // count can't wrap around to a small number for a huge volume.
+        unsigned Count = 1;
+        for (unsigned axis = 0; axis < 3; axis++)
+        {
+            unsigned Span = (unsigned)(High[axis] - Low[axis]) + 1;
+            if (Span > MaxCellsPerProxy)
+                return MaxCellsPerProxy + 1;
+
+            Count *= Span;
+        }
+
+        return Count;
+    }
+
+    unsigned BroadPhase::HashCell(int x, int y, int z) const
+    {
+        // BucketStart holds one more element than there are buckets, and the
+        // bucket count is always a power of two.
+        unsigned Mask = (unsigned)BucketStart.size() - 2;
+        return (((unsigned)x * 73856093u) ^ ((unsigned)y * 19349663u) ^ ((unsigned)z * 83492791u)) & Mask;
+    }
+
+    void BroadPhase::BuildGrid()
+    {
+        // Work out the volumes and how many entries the grid will need.
+        unsigned EntryCount = 0;
+        LargeProxies.clear();
+        IsLargeProxy.assign(Proxies.size(), false);
+
+        for (unsigned i = 0; i < Proxies.size(); i++)
+        {
+            Proxy& proxy = Proxies[i];
+            CalculateVolume(*proxy.Object, proxy.Volume);
+            proxy.Volume.Enlarge(Margin);
+
+            int Low[3], High[3];
+            unsigned Count = GetCellRange(proxy.Volume, Low, High);
+
+            if (Count > MaxCellsPerProxy)
+            {
+                LargeProxies.push_back(i);
+                IsLargeProxy[i] = true;
+            }
+
+            else
+                EntryCount += Count;
+        }
+
+        unsigned BucketCount = 64;
+        while (BucketCount < EntryCount * 2)
+            BucketCount <<= 1;
+
+        // Counting sort of the entries into their buckets: count the entries
+        // of each bucket, turn the counts into start offsets, then scatter.
+        BucketStart.assign(BucketCount + 1, 0);
+        GridEntries.resize(EntryCount);
+
+        for (unsigned i = 0; i < Proxies.size(); i++)
+        {
+            if (IsLargeProxy[i])
+                continue;
+
+            int Low[3], High[3];
+            GetCellRange(Proxies[i].Volume, Low, High);
+
+            for (int x = Low[0]; x <= High[0]; x++)
+                for (int y = Low[1]; y <= High[1]; y++)
+                    for (int z = Low[2]; z <= High[2]; z++)
+                        BucketStart[HashCell(x, y, z) + 1]++;
+        }
+
+        for (unsigned i = 0; i < BucketCount; i++)
+            BucketStart[i + 1] += BucketStart[i];
+
+        for (unsigned i = 0; i < Proxies.size(); i++)
+        {
+            if (IsLargeProxy[i])
+                continue;
+
+            int Low[3], High[3];
+            GetCellRange(Proxies[i].Volume, Low, High);
+
+            for (int x = Low[0]; x <= High[0]; x++)
+                for (int y = Low[1]; y <= High[1]; y++)
+                    for (int z = Low[2]; z <= High[2]; z++)
+                    {
+                        // BucketStart[bucket] is used as the fill cursor, so
+                        // once all entries are placed it has moved to where
+                        // the next bucket starts.
+                        unsigned Bucket = HashCell(x, y, z);
+                        GridEntry& Entry = GridEntries[BucketStart[Bucket]++];
+                        Entry.ProxyId = i;
+                        Entry.Cell[0] = x;
+                        Entry.Cell[1] = y;
+                        Entry.Cell[2] = z;
+                    }
+        }
+
+        // Shift the cursors back to get the start of each bucket again.
+        for (unsigned i = BucketCount; i > 0; i--)
+            BucketStart[i] = BucketStart[i - 1];
+        BucketStart[0] = 0;
+    }
+
+    unsigned BroadPhase::FindPotentialContacts(FrameVector<PotentialContact<Body>>& Contacts) const
+    {
+        Contacts.clear();
+
+        switch (BroadPhaseType)
+        {
+        case bp_BruteForce: {
+            for (unsigned i = 0; i < Proxies.size(); i++)
+            {
+                for (unsigned j = i + 1; j < Proxies.size(); j++)
+                {
+                    PotentialContact<Body> Pair;
+                    Pair.Object[0] = Proxies[i].Object;
+                    Pair.Object[1] = Proxies[j].Object;
+                    Contacts.push_back(Pair);
+                }
+            }
+            break;
+        }
+
+        case bp_DynamicTree: {
+            Tree.GetPotentialContacts(Contacts);
+            break;
+        }
+
+        case bp_SpatialHash: {
+            float InverseCellSize = 1.0f / CellSize;
+
+            for (unsigned Bucket = 0; Bucket + 1 < BucketStart.size(); Bucket++)
+            {
+                unsigned End = BucketStart[Bucket + 1];
+                for (unsigned i = BucketStart[Bucket]; i < End; i++)
+                {
+                    const GridEntry& One = GridEntries[i];
+                    for (unsigned j = i + 1; j < End; j++)
+                    {
+                        const GridEntry& Two = GridEntries[j];
+
+                        // Skip other cells that ended up in the same bucket.
+                        if (One.Cell[0] != Two.Cell[0] || One.Cell[1] != Two.Cell[1] || One.Cell[2] != Two.Cell[2])
+                            continue;
+
+                        const AABB& VolumeOne = Proxies[One.ProxyId].Volume;
+                        const AABB& VolumeTwo = Proxies[Two.ProxyId].Volume;
+                        if (!VolumeOne.BroadPhaseCollisionTest(VolumeTwo))
+                            continue;
+
+                        // Two volumes can share many cells. The pair is only
+                        // reported from the cell holding the lowest corner of
+                        // their overlap, so it comes out exactly once.
+                        bool Owner = true;
+                        for (unsigned axis = 0; axis < 3 && Owner; axis++)
+                        {
+                            float Corner = (VolumeOne.Min[axis] > VolumeTwo.Min[axis]) ? VolumeOne.Min[axis] : VolumeTwo.Min[axis];
+                            Owner = (GetCell(Corner * InverseCellSize) == One.Cell[axis]);
+                        }
+
+                        if (!Owner)
+                            continue;
+
+                        PotentialContact<Body> Pair;
+                        Pair.Object[0] = Proxies[One.ProxyId].Object;
+                        Pair.Object[1] = Proxies[Two.ProxyId].Object;
+                        Contacts.push_back(Pair);
+                    }
+                }
+            }
+
+            // Bodies kept out of the grid are tested against everything.
+            for (unsigned i = 0; i < LargeProxies.size(); i++)
+            {
+                unsigned Large = LargeProxies[i];
+                for (unsigned j = 0; j < Proxies.size(); j++)
+                {
+                    if (j == Large || (IsLargeProxy[j] && j < Large))
+                        continue;
+
+                    if (!Proxies[Large].Volume.BroadPhaseCollisionTest(Proxies[j].Volume))
+                        continue;
+
+                    PotentialContact<Body> Pair;
+                    Pair.Object[0] = Proxies[Large].Object;
+                    Pair.Object[1] = Proxies[j].Object;
+                    Contacts.push_back(Pair);
+                }
+            }
+            break;
+        }
+
+        case bp_SweepAndPrune: {
+            // Every pair is in two lists, it is taken from the lower proxy's.
+            for (unsigned i = 0; i < Proxies.size(); i++)
+            {
+                const std::vector<unsigned>& List = Partners[i];
+                for (unsigned k = 0; k < List.size(); k++)
+                {
+                    if (List[k] < i)
+                        continue;
+
+                    PotentialContact<Body> Pair;
+                    Pair.Object[0] = Proxies[i].Object;
+                    Pair.Object[1] = Proxies[List[k]].Object;
+                    Contacts.push_back(Pair);
+                }
+            }
+            break;
+        }
+
+        default:
+            break;
+        }
+
+        // The structures above only know about volumes, the pairs their
+        // bodies or filters rule out are taken out in one pass.
+        unsigned Kept = 0;
+        for (unsigned i = 0; i < Contacts.size(); i++)
+        {
+            if (ShouldPair(*Contacts[i].Object[0], *Contacts[i].Object[1]))
+                Contacts[Kept++] = Contacts[i];
+        }
+
+        Contacts.resize(Kept);
+
+        FindStaticContacts(Contacts);
+
+        return (unsigned)Contacts.size();
+    }
+
+    void BroadPhase::FindStaticContacts(FrameVector<PotentialContact<Body>>& Contacts) const
+    {
+        if (StaticTree.GetLeafCount() == 0)
+            return;
+
+        for (unsigned i = 0; i < Proxies.size(); i++)
+        {
+            const Proxy& proxy = Proxies[i];
+
+            // A sleeping body can't have moved into anything static.
+            if (proxy.Object->GetType() != Body::bt_Dynamic || !proxy.Object->GetAwake())
+                continue;
+
+            AABB Volume;
+            if (BroadPhaseType == bp_DynamicTree)
+                Volume = proxy.Leaf->Volume;
+
+            else if (BroadPhaseType == bp_BruteForce)
+            {
+                CalculateVolume(*proxy.Object, Volume);
+                Volume.Enlarge(Margin);
+            }
+
+            else
+                Volume = proxy.Volume;
+
+            StaticTree.Query(Volume, [&Contacts, &proxy](Body* Static)
+            {
+                if (!ShouldCollide(proxy.Object->GetCollisionFilter(), Static->GetCollisionFilter()))
+                    return;
+
+                PotentialContact<Body> Pair;
+                Pair.Object[0] = proxy.Object;
+                Pair.Object[1] = Static;
+                Contacts.push_back(Pair);
+            });
+        }
+    }
+
+    void BroadPhase::SetMargin(float margin)
+    {
+        Margin = margin;
+    }
+
+    void BroadPhase::SetCellSize(float size)
+    {
+        assert(size > 0.0f);
+        CellSize = size;
+    }
+}
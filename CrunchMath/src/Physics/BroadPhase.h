@@ -0,0 +1,290 @@
+#pragma once
+#include <vector>
+#include "../Math/AABB.h"
+#include "../Math/BVH/BVHDS.hpp"
+#include "Collisions.h"
+#include "FrameArena.h"
+
+namespace CrunchMath {
+
+    /**
+     * The broad phase finds the pairs of bodies that could possibly be
+     * touching, so that only those have to go through the (much more
+     * expensive) CollisionDetector.
+     *
+     * Every body the World creates is registered as a proxy. How the
+     * proxies are searched depends on the broad phase type:
+     *
+     * bp_DynamicTree keeps each proxy in a dynamic AABB tree with an
+     * enlarged ("fat") volume, so a body that only moves a little each
+     * frame never touches the tree; only bodies that leave their fat
+     * volume are reinserted. This is the default and copes with any scene.
+     *
+     * bp_SweepAndPrune keeps the min/max endpoints of every volume sorted
+     * along each axis. They are re-sorted with an insertion sort every
+     * update, which is close to linear when bodies move a little each
+     * frame, and the set of overlapping pairs is only touched when two
+     * endpoints swap. Removing a body only marks its endpoints, the next
+     * sort drops them, and only its own pairs are looked at, so bodies
+     * can come and go every frame. Best suited to piles of similar sized
+     * bodies.
+     *
+     * bp_SpatialHash bins the volumes into a hashed uniform grid every
+     * update and only tests bodies sharing a cell. The bins are built
+     * with a counting sort into one flat array, so nothing is allocated
+     * per cell. It beats the others on large numbers of small, equally
+     * sized bodies, as long as the cell size is set close to their size.
+     * Bodies spanning too many cells are kept out of the grid and tested
+     * against everything instead.
+     *
+     * bp_BruteForce hands every pair of bodies to the narrow phase. It is
+     * only kept as a reference to compare the others against.
+     *
+     * Static bodies are kept out of all of these, in a tree of their own
+     * that is only touched when a static body is added, removed or moved.
+     * Only awake dynamic bodies look for pairs in it, so static bodies
+     * cost nothing per frame. Kinematic bodies go with the dynamic ones,
+     * but pairs of two kinematic bodies are dropped.
+     *
+     * Pairs whose CollisionFilters keep them apart are dropped as well,
+     * so they never reach the narrow phase.
+     */
+    class BroadPhase
+    {
+    public:
+        enum Type
+        {
+            bp_BruteForce,
+            bp_DynamicTree,
+            bp_SweepAndPrune,
+            bp_SpatialHash
+        };
+
+        BroadPhase();
+
+        /**
+         * Switches to another broad phase type. The registered bodies are
+         * moved over to the new structure.
+         */
+        void SetType(Type type);
+
+        Type GetType() const;
+
+        /**
+         * Registers a body with the broad phase. Its volume is built from
+         * the body's current transform, on the next Update for static
+         * bodies.
+         */
+        void Insert(Body* body);
+
+        /**
+         * Has the volume of a static body rebuilt on the next Update,
+         * after it has been moved.
+         */
+        void UpdateStatic(Body* body);
+
+        /**
+         * Unregisters a body. The last registered body takes over its
+         * proxy id, so the proxies stay packed.
+         */
+        void Remove(Body* body);
+
+        /**
+         * Brings the broad phase structure up to date with the current
+         * transform of the bodies.
+         */
+        void Update();
+
+        /**
+         * Fills the array with every pair of bodies whose volumes overlap
+         * and that may collide. Previous content of the array is discarded.
+         *
+         * @return The number of potential contacts found.
+         */
+        unsigned FindPotentialContacts(FrameVector<PotentialContact<Body>>& Contacts) const;
+
+        /**
+         * Sets how far (in world units) the volumes extend past the bodies.
+         * Larger margins mean fewer tree updates but more potential contacts.
+         */
+        void SetMargin(float margin);
+
+        /**
+         * Sets the size of the grid cells used by bp_SpatialHash. It works
+         * best at about the size of the typical body.
+         */
+        void SetCellSize(float size);
+
+    private:
+        /**
+         * Holds what the broad phase knows about a single body, indexed
+         * by Body::ProxyId.
+         */
+        struct Proxy
+        {
+            Body* Object;
+
+            /** Holds the tree leaf of the proxy (bp_DynamicTree only). */
+            BVHNode<AABB, Body>* Leaf;
+
+            /** Holds the enlarged volume of the proxy (bp_SweepAndPrune and bp_SpatialHash only). */
+            AABB Volume;
+
+            /** Holds the position of the min [0] and max [1] endpoint on each axis (bp_SweepAndPrune only). */
+            unsigned EndPoint[3][2];
+        };
+
+        /** A static body, indexed by Body::ProxyId. */
+        struct StaticProxy
+        {
+            Body* Object;
+
+            /** Holds the leaf of the proxy in StaticTree, null until the next Update places it. */
+            BVHNode<AABB, Body>* Leaf;
+        };
+
+        /**
+         * One end of a proxy's extent along an axis. The lowest bit of
+         * Data tells whether it is the max endpoint, the rest is the
+         * proxy id.
+         */
+        struct EndPoint
+        {
+            float Value;
+            unsigned Data;
+        };
+
+        /**
+         * A proxy filed under one grid cell. The cell coordinates are kept
+         * to tell apart cells that hash to the same bucket.
+         */
+        struct GridEntry
+        {
+            unsigned ProxyId;
+            int Cell[3];
+        };
+
+        /**
+         * Calculates the tight world space AABB of a body from its
+         * transform and shape.
+         */
+        static void CalculateVolume(const Body& body, AABB& Volume);
+
+        /**
+         * Returns whether a pair found overlapping is handed on: one of
+         * the bodies has to be dynamic, and their filters must agree.
+         */
+        static bool ShouldPair(const Body& One, const Body& Two);
+
+        void InsertLeaf(unsigned ProxyId);
+
+        /** Places the static proxies that have no leaf yet in StaticTree. */
+        void PlaceStatics();
+
+        /** Appends the pairs of every awake dynamic proxy with the static bodies. */
+        void FindStaticContacts(FrameVector<PotentialContact<Body>>& Contacts) const;
+        void InsertEndPoints(unsigned ProxyId);
+
+        /**
+         * Takes the pairs of a proxy out of the sweep and prune axes and
+         * marks its endpoints dead, to be dropped by the next SortAxis.
+         */
+        void RemoveEndPoints(unsigned ProxyId);
+
+        /** Renames a proxy in the endpoints and the pairs (bp_SweepAndPrune only). */
+        void RenameEndPoints(unsigned From, unsigned To);
+
+        /** Adds a pair to the overlapping pairs, if it isn't there yet. */
+        void AddPair(unsigned ProxyOne, unsigned ProxyTwo);
+
+        /** Takes a pair out of the overlapping pairs, if it is there. */
+        void RemovePair(unsigned ProxyOne, unsigned ProxyTwo);
+
+        /** Takes a proxy out of the partners of another, returns whether it was there. */
+        static bool RemovePartner(std::vector<unsigned>& List, unsigned ProxyId);
+
+        /**
+         * Insertion sorts the endpoints of one axis, adding and removing
+         * pairs as min and max endpoints pass each other. Dead endpoints
+         * are dropped on the way.
+         */
+        void SortAxis(unsigned axis);
+
+        /**
+         * Fills the grid buckets with the current volumes of all proxies.
+         */
+        void BuildGrid();
+
+        /**
+         * Finds the range of grid cells a volume touches. Returns the number
+         * of cells, or MaxCellsPerProxy + 1 for any range past MaxCellsPerProxy.
+         */
+        unsigned GetCellRange(const AABB& Volume, int Low[3], int High[3]) const;
+
+        /**
+         * Returns the cell a coordinate, already divided by the cell size,
+         * falls into. Coordinates too far out for an int are clamped.
+         */
+        static int GetCell(float Coordinate);
+
+        unsigned HashCell(int x, int y, int z) const;
+
+        /** Holds the active broad phase type. */
+        Type BroadPhaseType;
+
+        /** Holds all the registered proxies. */
+        std::vector<Proxy> Proxies;
+
+        /** Holds the hierarchy of fat volumes. */
+        BVHTree<AABB, Body> Tree;
+
+        /** Holds the static bodies. */
+        std::vector<StaticProxy> StaticProxies;
+
+        /** Holds the hierarchy of the static bodies' volumes. */
+        BVHTree<AABB, Body> StaticTree;
+
+        /** Holds whether some StaticProxies wait for a leaf. */
+        bool StaticsMoved = false;
+
+
+        /** Holds the sorted endpoints of every proxy along x, y and z. */
+        std::vector<EndPoint> Axes[3];
+
+        /**
+         * Holds the pairs whose volumes currently overlap on all three axes,
+         * as the other proxy of every pair of each proxy, indexed by proxy
+         * id. A pair is in the lists of both its proxies. Never shrinks, so
+         * the lists of removed proxies are reused by the next ones with
+         * their memory, and a settled scene allocates nothing.
+         */
+        std::vector<std::vector<unsigned>> Partners;
+
+        /** Marks an endpoint whose proxy has been removed. */
+        const static unsigned DeadEndPoint = 0xffffffff;
+
+        /** Holds the number of cells above which a proxy is kept out of the grid. */
+        const static unsigned MaxCellsPerProxy = 64;
+
+        /** Holds the edge length of a grid cell. */
+        float CellSize;
+
+        /**
+         * Holds where each bucket starts in GridEntries, bucket i runs up
+         * to BucketStart[i + 1].
+         */
+        std::vector<unsigned> BucketStart;
+
+        /** Holds the entries of all buckets, sorted by bucket. */
+        std::vector<GridEntry> GridEntries;
+
+        /** Holds the proxies too large to be put into the grid. */
+        std::vector<unsigned> LargeProxies;
+
+        /** Holds whether each proxy is in LargeProxies. */
+        std::vector<bool> IsLargeProxy;
+
+        /** Holds the extra space added around each body's volume. */
+        float Margin;
+    };
+}
@@ -2,14 +2,27 @@
 #include <assert.h>
 #include <cstdlib>
 #include <cstdio>
+#include <cfloat>
 #include "../Math/OBB.h"
 #include "Collisions.h"
 
 namespace CrunchMath {
 
+    // The shape type of a body is checked before any of its tests runs,
+    // so the half sizes can be read without going through the vtable.
+    static inline const Vec3& BoxHalfSizes(const Body& body)
+    {
+        return static_cast<const cmBox*>(body.GetShape())->GetHalfSizes();
+    }
+
+    static inline float SphereRadius(const Body& body)
+    {
+        return static_cast<const cmSphere*>(body.GetShape())->GetRadius();
+    }
+
     static inline float TransformToAxis(const Body& body, const Vec3& axis)
     {
-        Vec3 HalfSize = *((Vec3*)body.GetShape()->GetHalfSize());
+        Vec3 HalfSize = BoxHalfSizes(body);
         return
             (
                 HalfSize.x * fabs(DotProduct(axis, body.GetTransform().GetColumnVector(0))) +
@@ -31,7 +44,19 @@ namespace CrunchMath {
     static inline bool TryAxis(const Body& One, const Body& Two, Vec3 axis, const Vec3& toCentre,
         unsigned index, float& SmallestPenetration, unsigned& SmallestCase)
     {
-        float Penetration = PenetrationOnAxis(One, Two, axis, toCentre);
+        //Edge-edge axes made from (almost) parallel edges are meaningless, skip them
+        if (DotProduct(axis, axis) < 0.0001f)
+            return true;
+        axis.Normalize();
+
+        float Extent = TransformToAxis(One, axis) + TransformToAxis(Two, axis);
+        float Penetration = fabs(DotProduct(toCentre, axis)) - Extent;
+
+        //Flat (2D) boxes have no extent along their normal. If they lie in the same
+        //plane that axis can neither separate them nor be used to push them apart.
+        if (Extent < 0.0001f)
+            return Penetration < 0.0001f;
+
         if (Penetration > 0)
             return false;
 
@@ -54,7 +79,7 @@ namespace CrunchMath {
             normal = normal * -1.0f;
         }
 
-        Vec3 vertex = *((Vec3*)Two.GetShape()->GetHalfSize());
+        Vec3 vertex = BoxHalfSizes(Two);
         if (DotProduct(Two.GetTransform().GetColumnVector(0), normal) < 0) vertex.x = -vertex.x;
         if (DotProduct(Two.GetTransform().GetColumnVector(1), normal) < 0) vertex.y = -vertex.y;
         if (DotProduct(Two.GetTransform().GetColumnVector(2), normal) < 0) vertex.z = -vertex.z;
@@ -65,46 +90,468 @@ namespace CrunchMath {
         contact->setBodyData(&One, &Two, Data->Friction, Data->Restitution);
     }
 
-    unsigned CollisionDetector::Collision(Body& One, Body& Two, CollisionData* Data)
+    /**
+     * Clips the polygon against the plane dot(normal, p) <= offset, writing
+     * the result into Out. Returns the number of vertices left.
+     */
+    static unsigned ClipPolygon(const Vec3* In, unsigned Count, const Vec3& normal, float offset, Vec3* Out)
     {
-        //I don't think this is necessary ... but i'd just leave it here until i'm ready to optimize the Collision Detection System
-       // OBB OneOBB(One->body->GetTransform().GetColumnVector(3), One->body->GetTransform(), One->HalfSize);
-       // OBB TwoOBB(Two->body->GetTransform().GetColumnVector(3), Two->body->GetTransform(), Two->HalfSize);
-       // if (!OneOBB.BroadPhaseCollisionTest(TwoOBB))
-        //    return 0;
+        unsigned OutCount = 0;
 
-        Vec3 CentreCentreDirection = Two.GetTransform().GetColumnVector(3) - One.GetTransform().GetColumnVector(3);
+        for (unsigned i = 0; i < Count; i++)
+        {
+            const Vec3& Start = In[i];
+            const Vec3& End = In[(i + 1) % Count];
+
+            float StartDistance = DotProduct(normal, Start) - offset;
+            float EndDistance = DotProduct(normal, End) - offset;
 
-        float Penetration = -0xfffffffff;
-        unsigned BestAxis = 0xffffff;
-         
-        //Only Supports 2D for now, on 2 Axis
-        for (int i = 0; i < 2; i++)
+            if (StartDistance <= 0)
+                Out[OutCount++] = Start;
+
+            //The edge crosses the plane, keep the crossing point too
+            if ((StartDistance < 0 && EndDistance > 0) || (StartDistance > 0 && EndDistance < 0))
+            {
+                float t = StartDistance / (StartDistance - EndDistance);
+                Out[OutCount++] = Start + (End - Start) * t;
+            }
+        }
+
+        return OutCount;
+    }
+
+    /**
+     * Generates the contacts of a face-something collision. The face of
+     * Reference along the best axis is clipped against the face of
+     * Incident pointing back at it, and each clipped point lying below
+     * the reference face becomes a contact. This gives up to 4 contacts,
+     * which is what lets a box rest on a face without rocking.
+     */
+    unsigned FillFaceBoxBox(Body& Reference, Body& Incident, const Vec3& toCentre, CollisionData* Data, unsigned best, float Pen)
+    {
+        const static unsigned MaxPoints = CollisionDetector::MaxContactsPerPair;
+        const float Epsilon = 0.0001f;
+
+        const Mat4x4& RefTransform = Reference.GetTransform();
+        const Mat4x4& IncTransform = Incident.GetTransform();
+        Vec3 RefHalfSize = BoxHalfSizes(Reference);
+        Vec3 IncHalfSize = BoxHalfSizes(Incident);
+        Vec3 RefPosition = RefTransform.GetColumnVector(3);
+
+        //Normal of the reference face, pointing towards the incident box
+        Vec3 normal = RefTransform.GetColumnVector(best);
+        if (DotProduct(normal, toCentre) < 0)
+            normal = normal * -1.0f;
+
+        //The incident face is the one most anti-parallel to the reference normal
+        unsigned IncAxis = 0;
+        float IncDot = 0.0f;
+        for (unsigned i = 0; i < 3; i++)
         {
-            if (!TryAxis(One, Two, One.GetTransform().GetColumnVector(i), CentreCentreDirection, (i), Penetration, BestAxis))
-                return false;
-            if (!TryAxis(One, Two, Two.GetTransform().GetColumnVector(i), CentreCentreDirection, (i + 3), Penetration, BestAxis))
-                return false;
+            float d = DotProduct(IncTransform.GetColumnVector(i), normal);
+            if (fabs(d) > fabs(IncDot))
+            {
+                IncDot = d;
+                IncAxis = i;
+            }
         }
 
-        Penetration = fabs(Penetration);
+        unsigned u = (IncAxis + 1) % 3;
+        unsigned v = (IncAxis + 2) % 3;
+        Vec3 IncCentre = IncTransform.GetColumnVector(3) +
+            IncTransform.GetColumnVector(IncAxis) * ((IncDot > 0) ? -IncHalfSize[IncAxis] : IncHalfSize[IncAxis]);
+        Vec3 U = IncTransform.GetColumnVector(u) * IncHalfSize[u];
+        Vec3 V = IncTransform.GetColumnVector(v) * IncHalfSize[v];
 
-        assert(BestAxis != 0xffffff);
+        //Clipping a quad against 4 planes leaves at most 8 vertices
+        Vec3 Polygon[8], Clipped[8];
+        Polygon[0] = IncCentre + U + V;
+        Polygon[1] = IncCentre - U + V;
+        Polygon[2] = IncCentre - U - V;
+        Polygon[3] = IncCentre + U - V;
+        unsigned Count = 4;
 
-        if (BestAxis < 3)
+        //Clip against the side planes of the reference face. Flat boxes get a
+        //thin slab instead of a plane, so points in their plane survive.
+        for (unsigned i = 1; i < 3 && Count > 0; i++)
+        {
+            unsigned axis = (best + i) % 3;
+            Vec3 Side = RefTransform.GetColumnVector(axis);
+            float Centre = DotProduct(Side, RefPosition);
+            float Half = (RefHalfSize[axis] > Epsilon) ? RefHalfSize[axis] : Epsilon;
+
+            Count = ClipPolygon(Polygon, Count, Side, Centre + Half, Clipped);
+            Count = ClipPolygon(Clipped, Count, Side * -1.0f, Half - Centre, Polygon);
+        }
+
+        //Keep the points lying below the reference face, or just above it within
+        //the tolerance, dropping the ones a flat face produces twice. The points
+        //that don't touch yet keep the resolver from rocking the box on one corner.
+        float FaceOffset = DotProduct(normal, RefPosition) + RefHalfSize[best];
+        Vec3 Points[8];
+        float Depths[8];
+        unsigned PointCount = 0;
+        for (unsigned i = 0; i < Count; i++)
         {
-            FillPointFaceBoxBox(One, Two, CentreCentreDirection, Data, BestAxis, Penetration);
-            Data->AddContacts(1);
+            float Depth = FaceOffset - DotProduct(normal, Polygon[i]);
+            if (Depth < -Data->Tolerance)
+                continue;
+
+            bool Duplicate = false;
+            for (unsigned j = 0; j < PointCount && !Duplicate; j++)
+            {
+                Vec3 Delta = Polygon[i] - Points[j];
+                Duplicate = (DotProduct(Delta, Delta) < Epsilon * Epsilon);
+            }
+
+            if (Duplicate)
+                continue;
+
+            Points[PointCount] = Polygon[i];
+            Depths[PointCount] = Depth;
+            PointCount++;
+        }
+
+        //Numerical trouble can clip everything away, fall back to the deepest vertex
+        if (PointCount == 0)
+        {
+            FillPointFaceBoxBox(Reference, Incident, toCentre, Data, best, Pen);
             return 1;
         }
 
+        //Cut the points down to the space left: start with the deepest one,
+        //then keep adding the point furthest from the ones already picked.
+        unsigned Limit = (Data->ContactsSpaceLeft < (int)MaxPoints) ? Data->ContactsSpaceLeft : MaxPoints;
+        unsigned Picked[MaxPoints];
+        unsigned PickedCount = 0;
+        if (PointCount <= Limit)
+        {
+            for (unsigned i = 0; i < PointCount; i++)
+                Picked[PickedCount++] = i;
+        }
+
+        else
+        {
+            unsigned Deepest = 0;
+            for (unsigned i = 1; i < PointCount; i++)
+                if (Depths[i] > Depths[Deepest])
+                    Deepest = i;
+
+            Picked[PickedCount++] = Deepest;
+            while (PickedCount < Limit)
+            {
+                unsigned Furthest = 0;
+                float FurthestDistance = -1.0f;
+                for (unsigned i = 0; i < PointCount; i++)
+                {
+                    float Closest = FLT_MAX;
+                    for (unsigned j = 0; j < PickedCount; j++)
+                    {
+                        Vec3 Delta = Points[i] - Points[Picked[j]];
+                        float Distance = DotProduct(Delta, Delta);
+                        if (Distance < Closest)
+                            Closest = Distance;
+                    }
+
+                    if (Closest > FurthestDistance)
+                    {
+                        FurthestDistance = Closest;
+                        Furthest = i;
+                    }
+                }
+
+                Picked[PickedCount++] = Furthest;
+            }
+        }
+
+        Contact* contact = Data->ptrCurrentContact;
+        for (unsigned i = 0; i < PickedCount; i++, contact++)
+        {
+            contact->ContactNormal = normal * -1.0f;
+            contact->Penetration = Depths[Picked[i]];
+            contact->ContactPoint = Points[Picked[i]];
+            contact->setBodyData(&Reference, &Incident, Data->Friction, Data->Restitution);
+        }
+
+        return PickedCount;
+    }
+
+    /**
+     * Finds the point half way between the closest points of two edges,
+     * each given by its mid point, direction and half length. If the
+     * closest points fall outside the edges (or the edges are parallel)
+     * the given mid point of one of them is used instead.
+     */
+    static inline Vec3 EdgeContactPoint(const Vec3& PointOne, const Vec3& DirectionOne, float SizeOne,
+        const Vec3& PointTwo, const Vec3& DirectionTwo, float SizeTwo, bool UseOne)
+    {
+        float SquareOne = DotProduct(DirectionOne, DirectionOne);
+        float SquareTwo = DotProduct(DirectionTwo, DirectionTwo);
+        float OneTwo = DotProduct(DirectionOne, DirectionTwo);
+
+        Vec3 ToStart = PointOne - PointTwo;
+        float StartOne = DotProduct(DirectionOne, ToStart);
+        float StartTwo = DotProduct(DirectionTwo, ToStart);
+
+        float Denominator = SquareOne * SquareTwo - OneTwo * OneTwo;
+        if (fabs(Denominator) < 0.0001f)
+            return UseOne ? PointOne : PointTwo;
+
+        float MuOne = (OneTwo * StartTwo - SquareTwo * StartOne) / Denominator;
+        float MuTwo = (SquareOne * StartTwo - OneTwo * StartOne) / Denominator;
+
+        if (MuOne > SizeOne || MuOne < -SizeOne || MuTwo > SizeTwo || MuTwo < -SizeTwo)
+            return UseOne ? PointOne : PointTwo;
+
+        Vec3 ClosestOne = PointOne + DirectionOne * MuOne;
+        Vec3 ClosestTwo = PointTwo + DirectionTwo * MuTwo;
+        return ClosestOne * 0.5f + ClosestTwo * 0.5f;
+    }
+
+    void FillEdgeEdgeBoxBox(Body& One, Body& Two, const Vec3& toCentre, CollisionData* Data, unsigned OneAxis, unsigned TwoAxis, float Pen, bool UseOne)
+    {
+        Contact* contact = Data->ptrCurrentContact;
+
+        const Mat4x4& OneTransform = One.GetTransform();
+        const Mat4x4& TwoTransform = Two.GetTransform();
+        Vec3 OneHalfSize = BoxHalfSizes(One);
+        Vec3 TwoHalfSize = BoxHalfSizes(Two);
+
+        Vec3 OneEdge = OneTransform.GetColumnVector(OneAxis);
+        Vec3 TwoEdge = TwoTransform.GetColumnVector(TwoAxis);
+
+        //The normal points from Two towards One, like the face contacts
+        Vec3 normal = CrossProduct(OneEdge, TwoEdge);
+        normal.Normalize();
+        if (DotProduct(normal, toCentre) > 0)
+            normal = normal * -1.0f;
+
+        //Find the mid point of the edge on each box closest to the other box
+        Vec3 PointOnOne = OneHalfSize;
+        Vec3 PointOnTwo = TwoHalfSize;
+        for (unsigned i = 0; i < 3; i++)
+        {
+            if (i == OneAxis)
+                PointOnOne[i] = 0;
+            else if (DotProduct(OneTransform.GetColumnVector(i), normal) > 0)
+                PointOnOne[i] = -PointOnOne[i];
+
+            if (i == TwoAxis)
+                PointOnTwo[i] = 0;
+            else if (DotProduct(TwoTransform.GetColumnVector(i), normal) < 0)
+                PointOnTwo[i] = -PointOnTwo[i];
+        }
+
+        PointOnOne = OneTransform * PointOnOne;
+        PointOnTwo = TwoTransform * PointOnTwo;
+
+        contact->ContactNormal = normal;
+        contact->Penetration = Pen;
+        contact->ContactPoint = EdgeContactPoint(PointOnOne, OneEdge, OneHalfSize[OneAxis],
+            PointOnTwo, TwoEdge, TwoHalfSize[TwoAxis], UseOne);
+        contact->setBodyData(&One, &Two, Data->Friction, Data->Restitution);
+    }
+
+    unsigned CollisionDetector::BoxAndBox(Body& One, Body& Two, CollisionData* Data)
+    {
+        Vec3 CentreCentreDirection = Two.GetTransform().GetColumnVector(3) - One.GetTransform().GetColumnVector(3);
+
+        //Separating axis test on all 15 axes: the 3 face normals of each box and the
+        //9 cross products of their edges. The faces of each box and the edges are
+        //tracked apart, so a face can be preferred when the depths are about equal.
+        float OnePenetration = -FLT_MAX, TwoPenetration = -FLT_MAX, EdgePenetration = -FLT_MAX;
+        unsigned OneAxis = 0xffffff, TwoAxis = 0xffffff, EdgeAxis = 0xffffff;
+
+        for (unsigned i = 0; i < 3; i++)
+        {
+            if (!TryAxis(One, Two, One.GetTransform().GetColumnVector(i), CentreCentreDirection, (i), OnePenetration, OneAxis))
+                return 0;
+            if (!TryAxis(One, Two, Two.GetTransform().GetColumnVector(i), CentreCentreDirection, (i + 3), TwoPenetration, TwoAxis))
+                return 0;
+        }
+
+        for (unsigned i = 0; i < 3; i++)
+        {
+            for (unsigned j = 0; j < 3; j++)
+            {
+                Vec3 axis = CrossProduct(One.GetTransform().GetColumnVector(i), Two.GetTransform().GetColumnVector(j));
+                if (!TryAxis(One, Two, axis, CentreCentreDirection, (6 + i * 3 + j), EdgePenetration, EdgeAxis))
+                    return 0;
+            }
+        }
+
+        //Switching between axes of almost the same depth from frame to frame makes
+        //resting contacts jitter, so another axis has to be clearly better to be used.
+        const float RelativeTolerance = 0.95f;
+        const float AbsoluteTolerance = 0.00001f;
+
+        float Penetration = OnePenetration;
+        unsigned BestAxis = OneAxis;
+        if (TwoAxis != 0xffffff && (BestAxis == 0xffffff || -TwoPenetration < -Penetration * RelativeTolerance - AbsoluteTolerance))
+        {
+            Penetration = TwoPenetration;
+            BestAxis = TwoAxis;
+        }
+
+        //Remember which box has the best face, it settles the contact point of parallel edges
+        bool FaceOnOne = (BestAxis < 3);
+
+        if (EdgeAxis != 0xffffff && (BestAxis == 0xffffff || -EdgePenetration < -Penetration * RelativeTolerance - AbsoluteTolerance))
+        {
+            Penetration = EdgePenetration;
+            BestAxis = EdgeAxis;
+        }
+
+        //Every axis was degenerate, i.e. both boxes have no volume at all
+        if (BestAxis == 0xffffff)
+            return 0;
+
+        Penetration = fabs(Penetration);
+
+        unsigned Count = 0;
+        if (BestAxis < 3)
+            Count = FillFaceBoxBox(One, Two, CentreCentreDirection, Data, BestAxis, Penetration);
+
         else if (BestAxis < 6)
+            Count = FillFaceBoxBox(Two, One, CentreCentreDirection * -1.0f, Data, BestAxis - 3, Penetration);
+
+        else
         {
-            FillPointFaceBoxBox(Two, One, CentreCentreDirection * -1.0f, Data, BestAxis - 3, Penetration);
-            Data->AddContacts(1);
-            return 1;
+            FillEdgeEdgeBoxBox(One, Two, CentreCentreDirection, Data, (BestAxis - 6) / 3, (BestAxis - 6) % 3, Penetration, !FaceOnOne);
+            Count = 1;
+        }
+
+        Data->AddContacts(Count);
+        return Count;
+    }
+
+    unsigned CollisionDetector::BoxAndSphere(Body& Box, Body& Ball, CollisionData* Data)
+    {
+        float Radius = SphereRadius(Ball);
+        Vec3 HalfSize = BoxHalfSizes(Box);
+        Vec3 Centre = Ball.GetTransform().GetColumnVector(3);
+
+        //OBB keeps its axes as rows, so it takes the world to local rotation
+        Mat3x3 Orientation(Box.GetTransform());
+        Orientation.Transpose();
+        OBB BoxOBB(Box.GetTransform().GetColumnVector(3), Orientation, HalfSize);
+
+        Vec3 ClosestPoint = BoxOBB.ClosestPointOBBPt(Centre);
+        Vec3 Offset = Centre - ClosestPoint;
+        float SquareDistance = DotProduct(Offset, Offset);
+        if (SquareDistance > Radius * Radius)
+            return 0;
+
+        Contact* contact = Data->ptrCurrentContact;
+
+        if (SquareDistance > 0.000001f)
+        {
+            //The normal points from the sphere towards the box
+            float Distance = sqrtf(SquareDistance);
+            contact->ContactNormal = Offset * (-1.0f / Distance);
+            contact->Penetration = Radius - Distance;
+        }
+
+        else
+        {
+            //The centre is inside the box, push it out through the closest face
+            Vec3 Local = Centre - Box.GetTransform().GetColumnVector(3);
+            unsigned Face = 0;
+            float FaceDistance = FLT_MAX;
+            for (unsigned i = 0; i < 3; i++)
+            {
+                float Distance = HalfSize[i] - fabs(DotProduct(Local, Box.GetTransform().GetColumnVector(i)));
+                if (Distance < FaceDistance)
+                {
+                    FaceDistance = Distance;
+                    Face = i;
+                }
+            }
+
+            Vec3 normal = Box.GetTransform().GetColumnVector(Face);
+            if (DotProduct(normal, Local) > 0)
+                normal = normal * -1.0f;
+
+            contact->ContactNormal = normal;
+            contact->Penetration = Radius + FaceDistance;
+        }
+
+        contact->ContactPoint = ClosestPoint;
+        contact->setBodyData(&Box, &Ball, Data->Friction, Data->Restitution);
+
+        Data->AddContacts(1);
+        return 1;
+    }
+
+    unsigned CollisionDetector::SphereAndBox(Body& Ball, Body& Box, CollisionData* Data)
+    {
+        return BoxAndSphere(Box, Ball, Data);
+    }
+
+    unsigned CollisionDetector::SphereAndSphere(Body& One, Body& Two, CollisionData* Data)
+    {
+        float RadiusOne = SphereRadius(One);
+        float RadiusTwo = SphereRadius(Two);
+
+        Vec3 PositionOne = One.GetTransform().GetColumnVector(3);
+        Vec3 PositionTwo = Two.GetTransform().GetColumnVector(3);
+
+        //The line between the centres, pointing towards One
+        Vec3 MidLine = PositionOne - PositionTwo;
+        float SquareDistance = DotProduct(MidLine, MidLine);
+        float RadiusSum = RadiusOne + RadiusTwo;
+        if (SquareDistance > RadiusSum * RadiusSum)
+            return 0;
+
+        Contact* contact = Data->ptrCurrentContact;
+
+        //Spheres sitting on the same centre can be pushed apart any way
+        float Distance = sqrtf(SquareDistance);
+        if (Distance > 0.000001f)
+            contact->ContactNormal = MidLine * (1.0f / Distance);
+        else
+            contact->ContactNormal = Vec3(0.0f, 1.0f, 0.0f);
+
+        contact->ContactPoint = PositionTwo + MidLine * 0.5f;
+        contact->Penetration = RadiusSum - Distance;
+        contact->setBodyData(&One, &Two, Data->Friction, Data->Restitution);
+
+        Data->AddContacts(1);
+        return 1;
+    }
+
+    unsigned CollisionDetector::Collision(Body& One, Body& Two, CollisionData* Data)
+    {
+        //Narrow phase kernels, indexed by the cmShape::Type of each body
+        typedef unsigned (*CollisionFunction)(Body&, Body&, CollisionData*);
+        const static CollisionFunction CollisionTable[2][2] =
+        {
+            { BoxAndBox,    BoxAndSphere },
+            { SphereAndBox, SphereAndSphere }
+        };
+
+        if (Data->ContactsSpaceLeft <= 0)
+            return 0;
+
+        cmShape::Type TypeOne = One.GetShape()->GetType();
+        cmShape::Type TypeTwo = Two.GetShape()->GetType();
+        assert(TypeOne <= cmShape::s_Sphere && TypeTwo <= cmShape::s_Sphere);
+
+        return CollisionTable[TypeOne][TypeTwo](One, Two, Data);
+    }
+
+    unsigned CollisionDetector::Collision(const PotentialContact<Body>* Pairs, unsigned PairCount, CollisionData* Data)
+    {
+        unsigned Count = 0;
+
+        for (unsigned i = 0; i < PairCount; i++)
+        {
+            if (Data->ContactsSpaceLeft <= 0)
+                break;
+
+            Count += Collision(*Pairs[i].Object[0], *Pairs[i].Object[1], Data);
         }
 
-        return 0;
+        return Count;
     }
 }
\ No newline at end of file
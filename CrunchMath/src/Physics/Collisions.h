@@ -1,5 +1,6 @@
 #pragma once
 #include "Contacts.h"
+#include "../Math/BVH/BVHDS.hpp"
 
 namespace CrunchMath {
 
@@ -17,7 +18,8 @@ namespace CrunchMath {
         virtual void Set(float x, float y, float z) {};
         virtual void Set(float x) {};
         virtual const void* GetHalfSize() const = 0;
-        virtual const Type GetType() const { return m_Shape; };
+        //Not virtual, so the narrow phase can pick a test without a call through the vtable.
+        const Type GetType() const { return m_Shape; };
     protected:
         Type m_Shape;
     };
@@ -40,6 +42,8 @@ namespace CrunchMath {
             return &HalfSize;
         }
 
+        const Vec3& GetHalfSizes() const { return HalfSize; }
+
     private:
         Vec3 HalfSize;
     };
@@ -63,6 +67,8 @@ namespace CrunchMath {
             return &Radius;
         }
 
+        float GetRadius() const { return Radius; }
+
     private:
         float Radius;
     };
@@ -107,6 +113,29 @@ namespace CrunchMath {
     class CollisionDetector
     {
     public:
+        /** Holds the most Contacts a single pair of bodies can generate. */
+        const static unsigned MaxContactsPerPair = 4;
+
+        /**
+         * Generates the Contacts between two bodies, picking the test
+         * that matches the shapes of the pair. Returns the number of
+         * Contacts generated.
+         */
         static unsigned Collision(Body& One, Body& Two, CollisionData* Data);
+
+        /**
+         * Runs the narrow phase over a flat array of pairs, as filled by
+         * the BroadPhase. Stops early once there is no space left for
+         * new Contacts. Returns the number of Contacts generated.
+         */
+        static unsigned Collision(const PotentialContact<Body>* Pairs, unsigned PairCount, CollisionData* Data);
+
+        static unsigned BoxAndBox(Body& One, Body& Two, CollisionData* Data);
+
+        static unsigned BoxAndSphere(Body& Box, Body& Ball, CollisionData* Data);
+
+        static unsigned SphereAndBox(Body& Ball, Body& Box, CollisionData* Data);
+
+        static unsigned SphereAndSphere(Body& One, Body& Two, CollisionData* Data);
     };
 }
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include <algorithm>
+#include "ContactCache.h"
+
+namespace CrunchMath {
+
+    ContactCache::ContactCache()
+    {
+        SetMatchDistance(0.01f);
+    }
+
+    bool ContactCache::MakePair(const Contact& contact, BodyPair& Pair)
+    {
+        // Contacts with the scenery keep their body first.
+        if (contact.body[1] != nullptr && contact.body[1] < contact.body[0])
+        {
+            Pair = BodyPair(contact.body[1], contact.body[0]);
+            return true;
+        }
+
+        Pair = BodyPair(contact.body[0], contact.body[1]);
+        return false;
+    }
+
+    Vec3 ContactCache::ToLocal(const Body& body, const Vec3& Point)
+    {
+        // The transform is a rotation and a translation, so its inverse is
+        // the transposed rotation applied to the offset.
+        const Mat4x4& Transform = body.GetTransform();
+        Vec3 Offset = Point - Transform.GetColumnVector(3);
+
+        return Vec3(DotProduct(Offset, Transform.GetColumnVector(0)),
+                    DotProduct(Offset, Transform.GetColumnVector(1)),
+                    DotProduct(Offset, Transform.GetColumnVector(2)));
+    }
+
+    const ContactCache::Manifold* ContactCache::FindManifold(const BodyPair& Pair) const
+    {
+        std::vector<Manifold>::const_iterator it = std::lower_bound(Manifolds.begin(), Manifolds.end(), Pair,
+            [](const Manifold& manifold, const BodyPair& pair) { return manifold.Pair < pair; });
+
+        return (it != Manifolds.end() && it->Pair == Pair) ? &*it : nullptr;
+    }
+
+    void ContactCache::SortManifolds()
+    {
+        std::sort(Manifolds.begin(), Manifolds.end(), [](const Manifold& a, const Manifold& b)
+        {
+            return a.Pair < b.Pair || (a.Pair == b.Pair && a.First < b.First);
+        });
+
+        unsigned Kept = 0;
+        for (unsigned i = 0; i < Manifolds.size(); i++)
+        {
+            if (i + 1 < Manifolds.size() && Manifolds[i + 1].Pair == Manifolds[i].Pair)
+                continue;
+
+            Manifolds[Kept++] = Manifolds[i];
+        }
+
+        Manifolds.resize(Kept);
+    }
+
+    void ContactCache::LoadImpulses(Contact* Contacts, unsigned ContactCount)
+    {
+        if (!RemovedBodies.empty())
+            DropRemoved();
+
+        if (Manifolds.empty())
+            return;
+
+        // Each old contact may only be taken over once, the bits of Taken
+        // tell which ones of the current manifold are gone.
+        BodyPair CurrentPair(nullptr, nullptr);
+        const Manifold* Current = nullptr;
+        unsigned Taken = 0;
+
+        for (unsigned i = 0; i < ContactCount; i++)
+        {
+            Contact& contact = Contacts[i];
+
+            BodyPair Pair;
+            float Sign = MakePair(contact, Pair) ? -1.0f : 1.0f;
+
+            if (i == 0 || Pair != CurrentPair)
+            {
+                Current = FindManifold(Pair);
+                CurrentPair = Pair;
+                Taken = 0;
+            }
+
+            if (Current == nullptr)
+                continue;
+
+            Vec3 LocalPoint = ToLocal(*Pair.first, contact.ContactPoint);
+            Vec3 Normal = contact.ContactNormal * Sign;
+
+            unsigned Best = Current->Count;
+            float BestDistance = SquareMatchDistance;
+            for (unsigned j = 0; j < Current->Count && j < 32; j++)
+            {
+                const CachedContact& Cached = CachedContacts[Current->First + j];
+                if ((Taken & (1u << j)) || DotProduct(Cached.Normal, Normal) < 0.95f)
+                    continue;
+
+                Vec3 Delta = Cached.LocalPoint - LocalPoint;
+                float Distance = DotProduct(Delta, Delta);
+                if (Distance <= BestDistance)
+                {
+                    BestDistance = Distance;
+                    Best = j;
+                }
+            }
+
+            if (Best == Current->Count)
+                continue;
+
+            const CachedContact& Cached = CachedContacts[Current->First + Best];
+            Taken |= (1u << Best);
+
+            contact.NormalImpulse = Cached.NormalImpulse;
+            contact.FrictionImpulse = Cached.FrictionImpulse * Sign;
+        }
+    }
+
+    void ContactCache::StoreImpulses(const Contact* Contacts, unsigned ContactCount)
+    {
+        Clear();
+
+        // The Manifolds are filed in contact order, and sorted at the end.
+        BodyPair CurrentPair(nullptr, nullptr);
+        Manifold* Current = nullptr;
+
+        for (unsigned i = 0; i < ContactCount; i++)
+        {
+            const Contact& contact = Contacts[i];
+
+            // Nothing to carry over from Contacts that never pushed.
+            if (contact.NormalImpulse <= 0.0f)
+                continue;
+
+            BodyPair Pair;
+            float Sign = MakePair(contact, Pair) ? -1.0f : 1.0f;
+
+            if (Current == nullptr || Pair != CurrentPair)
+            {
+                Manifold manifold;
+                manifold.Pair = Pair;
+                manifold.First = (unsigned)CachedContacts.size();
+                manifold.Count = 0;
+
+                Manifolds.push_back(manifold);
+                Current = &Manifolds.back();
+                CurrentPair = Pair;
+            }
+
+            CachedContact Cached;
+            Cached.LocalPoint = ToLocal(*Pair.first, contact.ContactPoint);
+            Cached.Normal = contact.ContactNormal * Sign;
+            Cached.NormalImpulse = contact.NormalImpulse;
+            Cached.FrictionImpulse = contact.FrictionImpulse * Sign;
+
+            CachedContacts.push_back(Cached);
+            Current->Count++;
+        }
+
+        SortManifolds();
+    }
+
+    void ContactCache::Clear()
+    {
+        Manifolds.clear();
+        CachedContacts.clear();
+        RemovedBodies.clear();
+    }
+
+    void ContactCache::Remove(const Body* body)
+    {
+        if (!Manifolds.empty())
+            RemovedBodies.push_back(body);
+    }
+
+    void ContactCache::DropRemoved()
+    {
+        std::sort(RemovedBodies.begin(), RemovedBodies.end());
+
+        // The CachedContacts of the pairs are left behind, they are only
+        // reachable through the Manifolds and go on the next StoreImpulses.
+        const std::vector<const Body*>& Removed = RemovedBodies;
+        Manifolds.erase(std::remove_if(Manifolds.begin(), Manifolds.end(), [&Removed](const Manifold& manifold)
+        {
+            return std::binary_search(Removed.begin(), Removed.end(), manifold.Pair.first) ||
+                   std::binary_search(Removed.begin(), Removed.end(), manifold.Pair.second);
+        }), Manifolds.end());
+
+        RemovedBodies.clear();
+    }
+
+    void ContactCache::SetMatchDistance(float distance)
+    {
+        SquareMatchDistance = distance * distance;
+    }
+}
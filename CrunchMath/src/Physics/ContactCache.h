@@ -0,0 +1,122 @@
+#pragma once
+#include <vector>
+#include "Contacts.h"
+
+namespace CrunchMath {
+
+    /**
+     * Remembers the impulses the ContactResolver applied at each contact,
+     * so the next frame can start out from them instead of from nothing
+     * (warm starting). Bodies resting on each other need about the same
+     * impulses every frame, so most of the work carries over and far
+     * fewer Velocity iterations are needed to settle them.
+     *
+     * Contacts are filed under the pair of bodies they belong to. A new
+     * contact takes over the impulses of the closest old contact of the
+     * same pair, if it lies within the match distance and its normal
+     * points the same way. Points are compared in the space of one of
+     * the bodies, so pairs moving together keep matching.
+     *
+     * The pairs are kept in a sorted array and looked up by binary
+     * search. Once it has grown to the number of Contacts of a busy
+     * frame, storing and loading impulses never touches the heap.
+     */
+    class ContactCache
+    {
+    public:
+        ContactCache();
+
+        /**
+         * Seeds the impulses of new Contacts from the matching Contacts
+         * stored on the last call to StoreImpulses. Contacts without a
+         * match start from zero.
+         */
+        void LoadImpulses(Contact* Contacts, unsigned ContactCount);
+
+        /**
+         * Replaces the cache content with the impulses of the given,
+         * resolved, Contacts. The Contacts of a pair are expected to be
+         * next to each other in the array, as the CollisionDetector
+         * generates them.
+         */
+        void StoreImpulses(const Contact* Contacts, unsigned ContactCount);
+
+        /** Forgets every stored contact. */
+        void Clear();
+
+        /**
+         * Forgets the stored contacts of a body, so a body created later
+         * at the same address doesn't take over its impulses. The body is
+         * only noted down, its contacts go on the next LoadImpulses, all
+         * at once with those of the other bodies removed in between.
+         */
+        void Remove(const Body* body);
+
+        /**
+         * Sets how far (in world units) a contact point may have moved
+         * and still take over the impulses of the old one.
+         */
+        void SetMatchDistance(float distance);
+
+    private:
+        /**
+         * The bodies of a pair, ordered so the pair is found whichever
+         * way round the CollisionDetector put them.
+         */
+        typedef std::pair<const Body*, const Body*> BodyPair;
+
+        /**
+         * A stored contact. Everything is given as seen by the first body
+         * of the BodyPair.
+         */
+        struct CachedContact
+        {
+            /** Holds the contact point in the first body's space. */
+            Vec3 LocalPoint;
+
+            Vec3 Normal;
+
+            float NormalImpulse;
+
+            /** Holds the Friction impulse on the first body, in world coordinates. */
+            Vec3 FrictionImpulse;
+        };
+
+        /** The stored Contacts of one pair, a range of CachedContacts. */
+        struct Manifold
+        {
+            BodyPair Pair;
+
+            unsigned First;
+            unsigned Count;
+        };
+
+        /** Returns the Manifold of the pair, or nullptr if it has none. */
+        const Manifold* FindManifold(const BodyPair& Pair) const;
+
+        /**
+         * Sorts the Manifolds by pair. Should a pair have been filed
+         * twice, only its last Manifold is kept.
+         */
+        void SortManifolds();
+
+        /** Drops the Manifolds of the RemovedBodies. */
+        void DropRemoved();
+
+        /** Orders the bodies of a contact, returns whether they had to be swapped. */
+        static bool MakePair(const Contact& contact, BodyPair& Pair);
+
+        static Vec3 ToLocal(const Body& body, const Vec3& Point);
+
+        /** Holds a Manifold for every pair with stored Contacts, sorted by pair. */
+        std::vector<Manifold> Manifolds;
+
+        std::vector<CachedContact> CachedContacts;
+
+        /** Holds the bodies removed since the Manifolds were last stored or purged. */
+        std::vector<const Body*> RemovedBodies;
+
+        /** Holds the square of the match distance. */
+        float SquareMatchDistance;
+    };
+}
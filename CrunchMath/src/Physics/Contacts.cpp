@@ -1,5 +1,6 @@
 #include <memory.h>
 #include <assert.h>
+#include <algorithm>
 #include "Contacts.h"
 
 namespace CrunchMath{
@@ -10,6 +11,8 @@ namespace CrunchMath{
         Contact::body[1] = two;
         Contact::Friction = Friction;
         Contact::Restitution = Restitution;
+        Contact::NormalImpulse = 0.0f;
+        Contact::FrictionImpulse = Vec3(0.0f, 0.0f, 0.0f);
     }
 
     void Contact::MatchAwakeState()
@@ -21,12 +24,12 @@ namespace CrunchMath{
         bool body0awake = body[0]->GetAwake();
         bool body1awake = body[1]->GetAwake();
 
-        // Wake up only the sleeping one
+        // Wake up only the sleeping one, unless it cannot move anyway.
         if (body0awake ^ body1awake)
         {
-            if (body0awake)
+            if (body0awake && body[1]->HasFiniteMass())
                 body[1]->SetAwake();
-            else
+            else if (body1awake && body[0]->HasFiniteMass())
                 body[0]->SetAwake();
         }
     }
@@ -195,9 +198,10 @@ namespace CrunchMath{
         // We will Calculate the impulse for each contact axis
         Vec3 impulseContact;
 
-        if (Friction == (float)0.0)
+        if (Friction == (float)0.0 || DesiredDeltaVelocity < 0.0f)
         {
-            // Use the short format for Frictionless Contacts
+            // Use the short format for Frictionless Contacts, and for
+            // Contacts giving back some of their impulse
             impulseContact = CalculateFrictionlessImpulse(InverseInertiaTensor);
         }
 
@@ -208,25 +212,68 @@ namespace CrunchMath{
             impulseContact = CalculateFrictionImpulse(InverseInertiaTensor);
         }
 
+        // A contact can only push, so it never takes back more than it
+        // has applied.
+        if (impulseContact.x < -NormalImpulse)
+            impulseContact.x = -NormalImpulse;
+        NormalImpulse += impulseContact.x;
+
         // Convert impulse to world coordinates
         Vec3 impulse = ContactToWorld * impulseContact;
+        FrictionImpulse += ContactToWorld * Vec3(0.0f, impulseContact.y, impulseContact.z);
+
+        ApplyImpulse(impulse, InverseInertiaTensor, VelocityChange, RotationChange);
+    }
 
-        // Split in the impulse into linear and Rotational components
-        Vec3 impulsiveTorque = CrossProduct(RelativeContactPosition[0] , impulse);
-        RotationChange[0] = InverseInertiaTensor[0] * impulsiveTorque;
-        VelocityChange[0] = Vec3(0.0f, 0.0f, 0.0f);
-        VelocityChange[0] += impulse * body[0]->GetInverseMass();
+    void Contact::ApplyWarmStartImpulse()
+    {
+        // The Resolver stops once no contact is closing, it never looks at
+        // the sliding Velocity again. A carried over Friction impulse would
+        // leave the bodies drifting, so only the normal impulse is used.
+        FrictionImpulse = Vec3(0.0f, 0.0f, 0.0f);
 
-        // Apply the changes
-        body[0]->AddVelocity(VelocityChange[0]);
-        body[0]->AddRotation(RotationChange[0]);
+        if (NormalImpulse <= 0.0f)
+        {
+            NormalImpulse = 0.0f;
+            return;
+        }
 
+        Mat3x3 InverseInertiaTensor[2];
+        body[0]->GetInverseInertiaTensorWorld(InverseInertiaTensor[0]);
         if (body[1])
+            body[1]->GetInverseInertiaTensorWorld(InverseInertiaTensor[1]);
+
+        Vec3 VelocityChange[2], RotationChange[2];
+        ApplyImpulse(ContactNormal * NormalImpulse, InverseInertiaTensor, VelocityChange, RotationChange);
+    }
+
+    void Contact::ApplyImpulse(const Vec3& impulse, Mat3x3* InverseInertiaTensor, Vec3 VelocityChange[2], Vec3 RotationChange[2])
+    {
+        // Bodies that cannot move are never written to, so islands sharing
+        // one can be resolved at the same time.
+        for (unsigned i = 0; i < 2; i++)
+        {
+            VelocityChange[i] = Vec3(0.0f, 0.0f, 0.0f);
+            RotationChange[i] = Vec3(0.0f, 0.0f, 0.0f);
+        }
+
+        if (body[0]->HasFiniteMass())
+        {
+            // Split in the impulse into linear and Rotational components
+            Vec3 impulsiveTorque = CrossProduct(RelativeContactPosition[0] , impulse);
+            RotationChange[0] = InverseInertiaTensor[0] * impulsiveTorque;
+            VelocityChange[0] += impulse * body[0]->GetInverseMass();
+
+            // Apply the changes
+            body[0]->AddVelocity(VelocityChange[0]);
+            body[0]->AddRotation(RotationChange[0]);
+        }
+
+        if (body[1] && body[1]->HasFiniteMass())
         {
             // Work out body one's linear and angular changes
             Vec3 impulsiveTorque = CrossProduct(impulse , RelativeContactPosition[1]);
             RotationChange[1] = InverseInertiaTensor[1] * impulsiveTorque;
-            VelocityChange[1] = Vec3(0.0f, 0.0f, 0.0f);
             VelocityChange[1] += impulse * -body[1]->GetInverseMass();
 
             // And Apply them.
@@ -365,7 +412,7 @@ namespace CrunchMath{
 
         // We need to work out the inertia of each object in the direction
         // of the contact normal, due to angular inertia only.
-        for (unsigned i = 0; i < 2; i++) if (body[i])
+        for (unsigned i = 0; i < 2; i++) if (body[i] && body[i]->HasFiniteMass())
         {
             Mat3x3 InverseInertiaTensor;
             body[i]->GetInverseInertiaTensorWorld(InverseInertiaTensor);
@@ -388,10 +435,18 @@ namespace CrunchMath{
             // continuing.
         }
 
-        // Loop through again calculating and Applying the changes
+        // Loop through again calculating and Applying the changes. Bodies
+        // that cannot move are never written to, so islands sharing one
+        // can be resolved at the same time.
         for (unsigned i = 0; i < 2; i++)
         {
-            if (body[i])
+            if (!body[i] || !body[i]->HasFiniteMass())
+            {
+                linearChange[i] = Vec3(0.0f, 0.0f, 0.0f);
+                angularChange[i] = Vec3(0.0f, 0.0f, 0.0f);
+            }
+
+            else
             {
                 // The linear and angular movements required are in proportion to
                 // the two inverse inertias.
@@ -461,10 +516,7 @@ namespace CrunchMath{
 
                 Quaternion Rq(0, Vec3(angularChange[i] * 1.0f));
                 Rq *= q;
-                q.w += Rq.w * ((float)0.5);
-                q.x += Rq.x * ((float)0.5);
-                q.y += Rq.y * ((float)0.5);
-                q.z += Rq.z * ((float)0.5);
+                q += Rq * ((float)0.5);
 
                 body[i]->SetOrientation(q);
 
@@ -496,6 +548,26 @@ namespace CrunchMath{
         ContactResolver::PositionIterations = PositionIterations;
     }
 
+    void ContactResolver::SetSolverType(SolverType type)
+    {
+        Solver = type;
+    }
+
+    ContactResolver::SolverType ContactResolver::GetSolverType() const
+    {
+        return Solver;
+    }
+
+    void ContactResolver::SetArena(FrameArena* arena)
+    {
+        AttachToArena(AdjacentBodies, arena);
+        AttachToArena(ContactSlots, arena);
+        AttachToArena(AdjacencyStart, arena);
+        AttachToArena(AdjacentContacts, arena);
+        AttachToArena(Constraints, arena);
+        WorstContacts.SetArena(arena);
+    }
+
     void ContactResolver::ResolveContacts(Contact* Contacts, unsigned numContacts, float duration)
     {
         // Make sure we have something to do.
@@ -505,11 +577,52 @@ namespace CrunchMath{
         // Prepare the Contacts for processing
         PrepareContacts(Contacts, numContacts, duration);
 
+        if (Solver == st_SequentialImpulse)
+        {
+            SolveSequential(Contacts, numContacts, duration);
+            return;
+        }
+
         // Resolve the interPenetration problems with the Contacts.
         AdjustPositions(Contacts, numContacts, duration);
 
+        // Carry over the impulses of the last frame, if there are any.
+        WarmStart(Contacts, numContacts, duration);
+
         // Resolve the Velocity problems with the Contacts.
-        AdjustVelocities(Contacts, numContacts, duration);
+        AdjustVelocities(Contacts, numContacts);
+    }
+
+    void ContactResolver::WarmStart(Contact* c, unsigned numContacts, float duration)
+    {
+        bool Started = false;
+        for (unsigned i = 0; i < numContacts; i++)
+        {
+            if (c[i].NormalImpulse > 0.0f)
+            {
+                c[i].MatchAwakeState();
+                Started = true;
+            }
+
+            c[i].ApplyWarmStartImpulse();
+        }
+
+        if (!Started)
+            return;
+
+        // Patching the Contacts after every impulse like AdjustVelocities
+        // does would cost a pass over all Contacts per contact. All the
+        // impulses are in, so just work the contact velocities out again.
+        for (unsigned i = 0; i < numContacts; i++)
+        {
+            float OldVelocity = c[i].ContactVelocity.x;
+
+            c[i].ContactVelocity = c[i].CalculateLocalVelocity(0, duration);
+            if (c[i].body[1])
+                c[i].ContactVelocity -= c[i].CalculateLocalVelocity(1, duration);
+
+            c[i].DesiredDeltaVelocity -= c[i].ContactVelocity.x - OldVelocity;
+        }
     }
 
     void ContactResolver::PrepareContacts(Contact* Contacts, unsigned numContacts, float duration)
@@ -521,32 +634,102 @@ namespace CrunchMath{
             // Calculate the internal contact data (inertia, basis, etc).
             contact->CalculateInternals(duration);
         }
+
+        // Only the worst first Resolver patches up the neighbours of the
+        // contact it resolved.
+        if (Solver == st_WorstFirst)
+            BuildAdjacency(Contacts, numContacts);
     }
 
-    void ContactResolver::AdjustVelocities(Contact* c, unsigned numContacts, float duration)
+    void ContactResolver::BuildAdjacency(Contact* c, unsigned numContacts)
+    {
+        AdjacentBodies.clear();
+        for (unsigned i = 0; i < numContacts; i++)
+        {
+            AdjacentBodies.push_back(c[i].body[0]);
+            if (c[i].body[1])
+                AdjacentBodies.push_back(c[i].body[1]);
+        }
+
+        std::sort(AdjacentBodies.begin(), AdjacentBodies.end());
+        AdjacentBodies.erase(std::unique(AdjacentBodies.begin(), AdjacentBodies.end()), AdjacentBodies.end());
+        unsigned BodyCount = (unsigned)AdjacentBodies.size();
+
+        // Counting sort of the Contacts into the slots of their bodies:
+        // count the entries of each slot, turn the counts into start
+        // offsets, then scatter.
+        ContactSlots.resize(numContacts * 2);
+        AdjacencyStart.assign(BodyCount + 1, 0);
+
+        for (unsigned i = 0; i < numContacts; i++)
+        {
+            for (unsigned b = 0; b < 2; b++)
+            {
+                if (!c[i].body[b])
+                {
+                    ContactSlots[i * 2 + b] = BodyCount;
+                    continue;
+                }
+
+                unsigned Slot = (unsigned)(std::lower_bound(AdjacentBodies.begin(), AdjacentBodies.end(), c[i].body[b]) - AdjacentBodies.begin());
+                ContactSlots[i * 2 + b] = Slot;
+                AdjacencyStart[Slot + 1]++;
+            }
+        }
+
+        for (unsigned i = 0; i < BodyCount; i++)
+            AdjacencyStart[i + 1] += AdjacencyStart[i];
+
+        AdjacentContacts.resize(AdjacencyStart[BodyCount]);
+
+        // AdjacencyStart[Slot] is used as the fill cursor, so once all
+        // entries are placed it has moved to where the next slot starts.
+        for (unsigned i = 0; i < numContacts * 2; i++)
+        {
+            if (ContactSlots[i] != BodyCount)
+                AdjacentContacts[AdjacencyStart[ContactSlots[i]]++] = i;
+        }
+
+        // Shift the cursors back to get the start of each slot again.
+        for (unsigned i = BodyCount; i > 0; i--)
+            AdjacencyStart[i] = AdjacencyStart[i - 1];
+        AdjacencyStart[0] = 0;
+    }
+
+    float ContactResolver::VelocitySeverity(const Contact& contact)
+    {
+        const static float VelocityEpsilon = (float)0.01f;
+
+        // Contacts separating faster than they should, because the
+        // Contacts around them pushed too hard, count as well as long as
+        // they still have impulse to give back.
+        float Change = contact.DesiredDeltaVelocity;
+        if (Change < -VelocityEpsilon && contact.NormalImpulse > 0.0f)
+            Change = -Change;
+
+        return Change;
+    }
+
+    void ContactResolver::AdjustVelocities(Contact* c, unsigned numContacts)
     {
         Vec3 VelocityChange[2], RotationChange[2];
         Vec3 deltaVel;
+        Vec3 Unchanged(0.0f, 0.0f, 0.0f);
+
+        WorstContacts.Reset(numContacts);
+        for (unsigned i = 0; i < numContacts; i++)
+            WorstContacts.Update(i, VelocitySeverity(c[i]));
 
         // iteratively handle impacts in order of severity.
         VelocityIterationsUsed = 0;
         while (VelocityIterationsUsed < VelocityIterations)
         {
             // Find contact with maximum magnitude of probable Velocity change.
-            float max = 0.0f;
-            unsigned index = numContacts;
-            for (unsigned i = 0; i < numContacts; i++)
-            {
-                if (c[i].DesiredDeltaVelocity > max)
-                {
-                    max = c[i].DesiredDeltaVelocity;
-                    index = i;
-                }
-            }
-
-            if (index == numContacts)
+            if (WorstContacts.TopPriority() <= 0.0f)
                 break;
 
+            unsigned index = WorstContacts.Top();
+
             // Match the awake state at the contact
             c[index].MatchAwakeState();
 
@@ -555,29 +738,37 @@ namespace CrunchMath{
 
             // With the change in Velocity of the two bodies, the update of
             // contact velocities means that some of the relative closing
-            // velocities need recomputing.
-            for (unsigned i = 0; i < numContacts; i++)
+            // velocities need recomputing. Only the Contacts of the two
+            // bodies can have changed.
+            for (unsigned d = 0; d < 2; d++)
             {
-                // Check each body in the contact
-                for (unsigned b = 0; b < 2; b++) if (c[i].body[b])
+                // Bodies that didn't move, like the scenery, change nothing.
+                unsigned Slot = ContactSlots[index * 2 + d];
+                if (Slot == AdjacentBodies.size() || (VelocityChange[d] == Unchanged && RotationChange[d] == Unchanged))
+                    continue;
+
+                for (unsigned Entry = AdjacencyStart[Slot]; Entry < AdjacencyStart[Slot + 1]; Entry++)
                 {
-                    // Check for a match with each body in the newly
-                    // resolved contact
-                    for (unsigned d = 0; d < 2; d++)
-                    {
-                        if (c[i].body[b] == c[index].body[d])
-                        {
-                            deltaVel = VelocityChange[d] + CrossProduct(RotationChange[d], c[i].RelativeContactPosition[b]);
-
-                            // The sign of the change is negative if we're dealing
-                            // with the second body in a contact.
-                            Mat3x3 WorldToContact = c[i].ContactToWorld;
-                            WorldToContact.Transpose();
-
-                            c[i].ContactVelocity += (WorldToContact * deltaVel) * (b ? -1 : 1);
-                            c[i].CalculateDesiredDeltaVelocity(duration);
-                        }
-                    }
+                    unsigned i = AdjacentContacts[Entry] >> 1;
+                    unsigned b = AdjacentContacts[Entry] & 1;
+
+                    deltaVel = VelocityChange[d] + CrossProduct(RotationChange[d], c[i].RelativeContactPosition[b]);
+
+                    // The sign of the change is negative if we're dealing
+                    // with the second body in a contact.
+                    Mat3x3 WorldToContact = c[i].ContactToWorld;
+                    WorldToContact.Transpose();
+
+                    Vec3 ContactDelta = (WorldToContact * deltaVel) * (b ? -1 : 1);
+                    c[i].ContactVelocity += ContactDelta;
+
+                    // Only take off what was just applied. Working the bounce
+                    // out again from the new Velocity would feed the impulse of
+                    // one contact back into the next when a body touches at
+                    // several points, and the body would gain energy.
+                    c[i].DesiredDeltaVelocity -= ContactDelta.x;
+
+                    WorstContacts.Update(i, VelocitySeverity(c[i]));
                 }
             }
             VelocityIterationsUsed++;
@@ -589,26 +780,23 @@ namespace CrunchMath{
         unsigned i, index;
         Vec3 linearChange[2], angularChange[2];
         Vec3 deltaPosition;
+        Vec3 Unchanged(0.0f, 0.0f, 0.0f);
+
+        WorstContacts.Reset(numContacts);
+        for (i = 0; i < numContacts; i++)
+            WorstContacts.Update(i, c[i].Penetration);
 
         // iteratively resolve interPenetrations in order of severity.
         PositionIterationsUsed = 0;
         while (PositionIterationsUsed < PositionIterations)
         {
             // Find biggest Penetration
-            float max = 0.0f;
-            index = numContacts;
-            for (i = 0; i < numContacts; i++)
-            {
-                if (c[i].Penetration > max)
-                {
-                    max = c[i].Penetration;
-                    index = i;
-                }
-            }
-
-            if (index == numContacts)
+            float max = WorstContacts.TopPriority();
+            if (max <= 0.0f)
                 break;
 
+            index = WorstContacts.Top();
+
             // Match the awake state at the contact
             c[index].MatchAwakeState();
 
@@ -616,33 +804,220 @@ namespace CrunchMath{
             c[index].ApplyPositionChange(linearChange, angularChange, max);
 
             // Again this action may have changed the Penetration of other
-            // bodies, so we update Contacts.
-            for (i = 0; i < numContacts; i++)
+            // bodies, so we update the Contacts of the two bodies.
+            for (unsigned d = 0; d < 2; d++)
+            {
+                // Bodies that didn't move, like the scenery, change nothing.
+                unsigned Slot = ContactSlots[index * 2 + d];
+                if (Slot == AdjacentBodies.size() || (linearChange[d] == Unchanged && angularChange[d] == Unchanged))
+                    continue;
+
+                for (unsigned Entry = AdjacencyStart[Slot]; Entry < AdjacencyStart[Slot + 1]; Entry++)
+                {
+                    i = AdjacentContacts[Entry] >> 1;
+                    unsigned b = AdjacentContacts[Entry] & 1;
+
+                    deltaPosition = linearChange[d] + CrossProduct(angularChange[d], c[i].RelativeContactPosition[b]);
+
+                    // The sign of the change is positive if we're
+                    // dealing with the second body in a contact
+                    // and negative otherwise (because we're
+                    // subtracting the resolution)..
+                    c[i].Penetration += DotProduct(deltaPosition, c[i].ContactNormal) * (b ? 1 : -1);
+
+                    WorstContacts.Update(i, c[i].Penetration);
+                }
+            }
+            PositionIterationsUsed++;
+        }
+    }
+
+    float ContactResolver::SequentialVelocity(const Contact& contact, unsigned Axis)
+    {
+        Vec3 Velocity = contact.body[0]->GetVelocity() + CrossProduct(contact.body[0]->GetRotation(), contact.RelativeContactPosition[0]);
+        if (contact.body[1])
+            Velocity -= contact.body[1]->GetVelocity() + CrossProduct(contact.body[1]->GetRotation(), contact.RelativeContactPosition[1]);
+
+        return DotProduct(Velocity, contact.ContactToWorld.GetColumnVector(Axis));
+    }
+
+    void ContactResolver::ApplySequentialImpulse(Contact& contact, const SequentialConstraint& Constraint, unsigned Axis, float Impulse)
+    {
+        Vec3 impulse = contact.ContactToWorld.GetColumnVector(Axis) * Impulse;
+
+        // Bodies that cannot move are never written to, so islands sharing
+        // one can be resolved at the same time.
+        if (contact.body[0]->HasFiniteMass())
+        {
+            contact.body[0]->AddVelocity(impulse * contact.body[0]->GetInverseMass());
+            contact.body[0]->AddRotation(Constraint.AngularResponse[0][Axis] * Impulse);
+        }
+
+        if (contact.body[1] && contact.body[1]->HasFiniteMass())
+        {
+            contact.body[1]->AddVelocity(impulse * -contact.body[1]->GetInverseMass());
+            contact.body[1]->AddRotation(Constraint.AngularResponse[1][Axis] * -Impulse);
+        }
+    }
+
+    void ContactResolver::SolveSequential(Contact* c, unsigned numContacts, float duration)
+    {
+        // Below this closing Velocity Contacts don't bounce, as in
+        // Contact::CalculateDesiredDeltaVelocity.
+        const static float VelocityLimit = (float)0.25f;
+
+        // Penetration left alone, so resting Contacts stay touching.
+        const static float PenetrationSlop = (float)0.001f;
+
+        // The share of the Penetration pushed out per step.
+        const static float PenetrationBias = (float)0.2f;
+
+        // The sweeps stop once no contact changes Velocity by more than this.
+        const static float VelocityEpsilon = (float)0.0001f;
+
+        if (Constraints.size() < numContacts)
+            Constraints.resize(numContacts);
+
+        Mat3x3 InverseInertiaTensor[2];
+        for (unsigned i = 0; i < numContacts; i++)
+        {
+            Contact& contact = c[i];
+            SequentialConstraint& Constraint = Constraints[i];
+
+            contact.body[0]->GetInverseInertiaTensorWorld(InverseInertiaTensor[0]);
+            float InverseMass = contact.body[0]->GetInverseMass();
+            if (contact.body[1])
             {
-                // Check each body in the contact
+                contact.body[1]->GetInverseInertiaTensorWorld(InverseInertiaTensor[1]);
+                InverseMass += contact.body[1]->GetInverseMass();
+            }
+
+            for (unsigned Axis = 0; Axis < 3; Axis++)
+            {
+                Vec3 Direction = contact.ContactToWorld.GetColumnVector(Axis);
+                float Response = InverseMass;
+
                 for (unsigned b = 0; b < 2; b++)
                 {
-                    if (c[i].body[b])
+                    if (!contact.body[b] || !contact.body[b]->HasFiniteMass())
                     {
-                        // Check for a match with each body in the newly
-                        // resolved contact
-                        for (unsigned d = 0; d < 2; d++)
-                        {
-                            if (c[i].body[b] == c[index].body[d])
-                            {
-                                deltaPosition = linearChange[d] + CrossProduct(angularChange[d], c[i].RelativeContactPosition[b]);
-
-                                // The sign of the change is positive if we're
-                                // dealing with the second body in a contact
-                                // and negative otherwise (because we're
-                                // subtracting the resolution)..
-                                c[i].Penetration += DotProduct(deltaPosition, c[i].ContactNormal) * (b ? 1 : -1);
-                            }
-                        }
+                        Constraint.AngularResponse[b][Axis] = Vec3(0.0f, 0.0f, 0.0f);
+                        continue;
                     }
+
+                    Vec3 Torque = CrossProduct(contact.RelativeContactPosition[b], Direction);
+                    Constraint.AngularResponse[b][Axis] = InverseInertiaTensor[b] * Torque;
+                    Response += DotProduct(Torque, Constraint.AngularResponse[b][Axis]);
                 }
+
+                Constraint.EffectiveMass[Axis] = (Response > 0.0f) ? 1.0f / Response : 0.0f;
+            }
+
+            // Contacts still apart may close the gap this step, but no
+            // more. Touching ones bounce, and get pushed out of Penetration
+            // over a few steps.
+            float ClosingVelocity = contact.ContactVelocity.x;
+            if (contact.Penetration < 0.0f)
+            {
+                Constraint.TargetVelocity = contact.Penetration / duration;
+            }
+
+            else
+            {
+                Constraint.TargetVelocity = 0.0f;
+                if (ClosingVelocity < -VelocityLimit)
+                    Constraint.TargetVelocity = -contact.Restitution * ClosingVelocity;
+
+                float Push = PenetrationBias * (contact.Penetration - PenetrationSlop) / duration;
+                if (Push > Constraint.TargetVelocity)
+                    Constraint.TargetVelocity = Push;
+            }
+
+            // The next Integrate adds this frame's Acceleration before it
+            // moves the bodies, the Contacts have to hold against that too.
+            if (contact.body[0]->GetAwake())
+                Constraint.TargetVelocity -= DotProduct(contact.body[0]->GetLastFrameAcceleration(), contact.ContactNormal) * duration;
+            if (contact.body[1] && contact.body[1]->GetAwake())
+                Constraint.TargetVelocity += DotProduct(contact.body[1]->GetLastFrameAcceleration(), contact.ContactNormal) * duration;
+
+            if (contact.Penetration > 0.0f || ClosingVelocity < 0.0f)
+                contact.MatchAwakeState();
+
+            // Start out from the impulses of the last frame, if there are any.
+            Constraint.Impulse = Vec3(0.0f, 0.0f, 0.0f);
+            if (contact.NormalImpulse > 0.0f)
+            {
+                Constraint.Impulse.x = contact.NormalImpulse;
+                Constraint.Impulse.y = DotProduct(contact.FrictionImpulse, contact.ContactToWorld.GetColumnVector(1));
+                Constraint.Impulse.z = DotProduct(contact.FrictionImpulse, contact.ContactToWorld.GetColumnVector(2));
+
+                for (unsigned Axis = 0; Axis < 3; Axis++)
+                    ApplySequentialImpulse(contact, Constraint, Axis, Constraint.Impulse[Axis]);
             }
-            PositionIterationsUsed++;
         }
+
+        for (VelocityIterationsUsed = 0; VelocityIterationsUsed < VelocityIterations; VelocityIterationsUsed++)
+        {
+            float LargestChange = 0.0f;
+
+            for (unsigned i = 0; i < numContacts; i++)
+            {
+                Contact& contact = c[i];
+                SequentialConstraint& Constraint = Constraints[i];
+
+                // Friction first, so the normal impulse, which matters
+                // most, is the last word on this contact. Friction may not
+                // exceed what the normal impulse so far allows.
+                float MaxFriction = contact.Friction * Constraint.Impulse.x;
+                for (unsigned Axis = 1; Axis < 3; Axis++)
+                {
+                    float Old = Constraint.Impulse[Axis];
+                    float New = Old - SequentialVelocity(contact, Axis) * Constraint.EffectiveMass[Axis];
+                    if (New > MaxFriction) New = MaxFriction;
+                    if (New < -MaxFriction) New = -MaxFriction;
+
+                    Constraint.Impulse[Axis] = New;
+                    ApplySequentialImpulse(contact, Constraint, Axis, New - Old);
+
+                    if (Constraint.EffectiveMass[Axis] > 0.0f)
+                    {
+                        float Change = fabsf(New - Old) / Constraint.EffectiveMass[Axis];
+                        if (Change > LargestChange)
+                            LargestChange = Change;
+                    }
+                }
+
+                // The sum of the normal impulses may only push.
+                float Old = Constraint.Impulse.x;
+                float New = Old + (Constraint.TargetVelocity - SequentialVelocity(contact, 0)) * Constraint.EffectiveMass[0];
+                if (New < 0.0f) New = 0.0f;
+
+                Constraint.Impulse.x = New;
+                ApplySequentialImpulse(contact, Constraint, 0, New - Old);
+
+                if (Constraint.EffectiveMass[0] > 0.0f)
+                {
+                    float Change = fabsf(New - Old) / Constraint.EffectiveMass[0];
+                    if (Change > LargestChange)
+                        LargestChange = Change;
+                }
+            }
+
+            if (LargestChange < VelocityEpsilon)
+            {
+                VelocityIterationsUsed++;
+                break;
+            }
+        }
+
+        // Hand the impulses back to the Contacts, for the ContactCache.
+        for (unsigned i = 0; i < numContacts; i++)
+        {
+            const SequentialConstraint& Constraint = Constraints[i];
+            c[i].NormalImpulse = Constraint.Impulse.x;
+            c[i].FrictionImpulse = c[i].ContactToWorld * Vec3(0.0f, Constraint.Impulse.y, Constraint.Impulse.z);
+        }
+
+        PositionIterationsUsed = 0;
     }
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 #include "Body.h"
+#include "FrameArena.h"
+#include "IndexedHeap.h"
 
 namespace CrunchMath {
 
@@ -39,6 +41,12 @@ namespace CrunchMath {
          */
         friend class ContactResolver;
 
+        /**
+         * The contact cache reads and seeds the impulses of the Contacts
+         * to carry them over from one frame to the next.
+         */
+        friend class ContactCache;
+
     public:
         /**
          * Holds the bodies that are involved in the contact. The
@@ -107,6 +115,20 @@ namespace CrunchMath {
          */
         Vec3 RelativeContactPosition[2];
 
+        /**
+         * Holds the total impulse applied along the contact normal so far
+         * in this Velocity resolution, including any impulse it was warm
+         * started with. A contact pushed apart too hard by the Contacts
+         * around it may take some of it back, but never more than this.
+         */
+        float NormalImpulse;
+
+        /**
+         * Holds the total Friction impulse applied to the first body so
+         * far in this Velocity resolution, in world coordinates.
+         */
+        Vec3 FrictionImpulse;
+
     protected:
         /**
          * Calculates internal data from state data. This is called before
@@ -155,6 +177,17 @@ namespace CrunchMath {
          */
         void ApplyVelocityChange(Vec3 VelocityChange[2], Vec3 RotationChange[2]);
 
+        /**
+         * Applies the normal impulse the contact was warm started with.
+         */
+        void ApplyWarmStartImpulse();
+
+        /**
+         * Applies a world space impulse at the contact point, to the
+         * first body and opposite to the second.
+         */
+        void ApplyImpulse(const Vec3& impulse, Mat3x3* InverseInertiaTensor, Vec3 VelocityChange[2], Vec3 RotationChange[2]);
+
         /**
          * Performs an inertia weighted Penetration resolution of this
          * contact alone.
@@ -230,6 +263,28 @@ namespace CrunchMath {
      */
     class ContactResolver
     {
+    public:
+        /**
+         * The ways the Resolver can work through the Contacts.
+         *
+         * st_WorstFirst is the algorithm described above. It keeps fixing
+         * the worst contact, and separates bodies by moving them.
+         *
+         * st_SequentialImpulse sweeps over the Contacts in order, each
+         * sweep applying to every contact the impulse that fixes it right
+         * now, while keeping the sum of its impulses pushing and its
+         * Friction inside the Friction cone (projected Gauss-Seidel). It
+         * does not move the bodies, Penetration is removed by asking for
+         * a little separating Velocity instead. The Friction of resting
+         * Contacts is solved together with the normal impulse, which
+         * makes it a lot better with stacks.
+         */
+        enum SolverType
+        {
+            st_WorstFirst,
+            st_SequentialImpulse
+        };
+
     protected:
         /**
          * Holds the number of iterations to perform when resolving
@@ -269,6 +324,23 @@ namespace CrunchMath {
          */
         void SetIterations(unsigned PositionIterations, unsigned VelocityIterations);
 
+        /**
+         * Selects the algorithm used to resolve the Contacts, st_WorstFirst
+         * by default. With st_SequentialImpulse the Velocity iterations are
+         * the number of sweeps over the Contacts, and the Position
+         * iterations are not used.
+         */
+        void SetSolverType(SolverType type);
+
+        SolverType GetSolverType() const;
+
+        /**
+         * Has the scratch arrays of the Resolver take their memory from
+         * the arena (the heap if null). The World calls it at the start of
+         * every Step, after the arena was Reset.
+         */
+        void SetArena(FrameArena* arena);
+
         /**
          * Resolves a set of Contacts for both Penetration and Velocity.
          *
@@ -305,16 +377,94 @@ namespace CrunchMath {
          */
         void PrepareContacts(Contact *ContactArray, unsigned numContacts, float duration);
 
+        /**
+         * Files the Contacts under the bodies they touch, so that the
+         * Contacts sharing a body with a resolved contact are found
+         * without a pass over all of them.
+         */
+        void BuildAdjacency(Contact *ContactArray, unsigned numContacts);
+
         /**
          * Resolves the Velocity issues with the given array of constraints,
          * using the given number of iterations.
          */
-        void AdjustVelocities(Contact *ContactArray, unsigned numContacts, float duration);
+        void AdjustVelocities(Contact *ContactArray, unsigned numContacts);
+
+        /**
+         * Applies the impulses the Contacts were warm started with, and
+         * brings the contact velocities up to date with them.
+         */
+        void WarmStart(Contact *ContactArray, unsigned numContacts, float duration);
 
         /**
          * Resolves the Positional issues with the given array of constraints,
          * using the given number of iterations.
          */
         void AdjustPositions(Contact *Contacts, unsigned numContacts, float duration);
+
+        /**
+         * Resolves the given Contacts with sequential impulses, see
+         * st_SequentialImpulse.
+         */
+        void SolveSequential(Contact *Contacts, unsigned numContacts, float duration);
+
+    private:
+        /**
+         * What SolveSequential works out once per contact before
+         * sweeping. Axis 0 is the contact normal, axes 1 and 2 the
+         * tangents, as in the contact basis.
+         */
+        struct SequentialConstraint
+        {
+            /** Holds the impulse that changes the Velocity along each axis by one. */
+            float EffectiveMass[3];
+
+            /** Holds the rotation change of each body per unit impulse along each axis. */
+            Vec3 AngularResponse[2][3];
+
+            /** Holds the Velocity along the normal the contact should end up with. */
+            float TargetVelocity;
+
+            /** Holds the impulses accumulated along each axis. */
+            Vec3 Impulse;
+        };
+
+        /** Returns the Velocity of the first body relative to the second along an axis of the contact. */
+        static float SequentialVelocity(const Contact& contact, unsigned Axis);
+
+        /** Applies an impulse along an axis of the contact, to the first body and opposite to the second. */
+        static void ApplySequentialImpulse(Contact& contact, const SequentialConstraint& Constraint, unsigned Axis, float Impulse);
+
+        /**
+         * Returns how badly a contact needs its Velocity resolved, zero or
+         * less if it doesn't.
+         */
+        static float VelocitySeverity(const Contact& contact);
+
+        SolverType Solver = st_WorstFirst;
+
+        /** Holds the bodies of the Contacts, sorted. A body's place in here is its slot. */
+        FrameVector<Body*> AdjacentBodies;
+
+        /** Holds the slot of each body of each contact, two per contact. */
+        FrameVector<unsigned> ContactSlots;
+
+        /**
+         * Holds where the entries of each slot start in AdjacentContacts,
+         * with one more entry at the end for where the last slot ends.
+         */
+        FrameVector<unsigned> AdjacencyStart;
+
+        /**
+         * Holds the Contacts of each body, as the contact index times two
+         * plus which body of the contact it is.
+         */
+        FrameVector<unsigned> AdjacentContacts;
+
+        /** Holds the Contacts ordered by how badly they need resolving. */
+        IndexedHeap WorstContacts;
+
+        /** Holds the constraints of the last SolveSequential call. */
+        FrameVector<SequentialConstraint> Constraints;
     };
 }
\ No newline at end of file
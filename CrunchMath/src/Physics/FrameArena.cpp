@@ -0,0 +1,144 @@
+#include "FrameArena.h"
+
+namespace CrunchMath {
+
+    FrameArena::FrameArena() : Current(nullptr)
+    {
+    }
+
+    FrameArena::~FrameArena()
+    {
+        FreeBlocks();
+    }
+
+    void* FrameArena::Allocate(size_t Size, size_t Alignment)
+    {
+        assert(Alignment != 0 && (Alignment & (Alignment - 1)) == 0 && Alignment <= 16);
+
+        Block* block = Current.load(std::memory_order_acquire);
+        for (;;)
+        {
+            if (block != nullptr)
+            {
+                size_t Used = block->Used.load(std::memory_order_relaxed);
+                for (;;)
+                {
+                    size_t Offset = (Used + Alignment - 1) & ~(Alignment - 1);
+                    if (Offset + Size > block->Size)
+                        break;
+
+                    if (block->Used.compare_exchange_weak(Used, Offset + Size, std::memory_order_relaxed))
+                        return block->GetData() + Offset;
+                }
+            }
+
+            block = Grow(block, Size + Alignment);
+        }
+    }
+
+    FrameArena::Block* FrameArena::Grow(Block* Full, size_t Size)
+    {
+        std::lock_guard<std::mutex> Lock(GrowLock);
+
+        // Another thread may have grown the arena while this one waited.
+        Block* block = Current.load(std::memory_order_acquire);
+        if (block != Full)
+            return block;
+
+        size_t BlockSize = MinBlockSize;
+        if (Full != nullptr && Full->Size * 2 > BlockSize)
+            BlockSize = Full->Size * 2;
+        if (Size > BlockSize)
+            BlockSize = Size;
+
+        block = NewBlock(BlockSize);
+        block->Next = Full;
+        HeapBlocks++;
+
+        Current.store(block, std::memory_order_release);
+        return block;
+    }
+
+    void FrameArena::Reset()
+    {
+        HighWater = GetHighWater();
+        HeapBlocks = 0;
+
+        Block* block = Current.load(std::memory_order_relaxed);
+        if (block == nullptr)
+            return;
+
+        Block* Oldest = block;
+        while (Oldest->Next != nullptr)
+            Oldest = Oldest->Next;
+
+        // Leave some room, so a Step a little busier than the busiest so
+        // far doesn't need another block right away.
+        size_t Size = HighWater + HighWater / 2;
+        if (Limit != 0 && Size > Limit)
+            Size = Limit;
+
+        // Keep the oldest block if it holds the busiest Step and is within
+        // the limit, otherwise start over with one block of that size.
+        if (Oldest->Size >= Size && (Limit == 0 || Oldest->Size <= Limit))
+        {
+            while (block != Oldest)
+            {
+                Block* Next = block->Next;
+                ::operator delete(block);
+                block = Next;
+            }
+        }
+        else
+        {
+            FreeBlocks();
+            block = NewBlock(Size);
+            HeapBlocks = 1;
+        }
+
+        block->Used.store(0, std::memory_order_relaxed);
+        Current.store(block, std::memory_order_relaxed);
+    }
+
+    size_t FrameArena::GetUsed() const
+    {
+        size_t Used = 0;
+        for (Block* block = Current.load(std::memory_order_relaxed); block != nullptr; block = block->Next)
+            Used += block->Used.load(std::memory_order_relaxed);
+
+        return Used;
+    }
+
+    size_t FrameArena::GetHighWater() const
+    {
+        size_t Used = GetUsed();
+        return (Used > HighWater) ? Used : HighWater;
+    }
+
+    void FrameArena::SetLimit(size_t Bytes)
+    {
+        Limit = Bytes;
+    }
+
+    FrameArena::Block* FrameArena::NewBlock(size_t Size)
+    {
+        Block* block = static_cast<Block*>(::operator new(HeaderSize + Size));
+        block->Next = nullptr;
+        block->Size = Size;
+        new (&block->Used) std::atomic<size_t>(0);
+        return block;
+    }
+
+    void FrameArena::FreeBlocks()
+    {
+        Block* block = Current.load(std::memory_order_relaxed);
+        while (block != nullptr)
+        {
+            Block* Next = block->Next;
+            ::operator delete(block);
+            block = Next;
+        }
+
+        Current.store(nullptr, std::memory_order_relaxed);
+    }
+}
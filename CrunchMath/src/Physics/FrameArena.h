@@ -0,0 +1,154 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include <assert.h>
+
+namespace CrunchMath {
+
+    /**
+     * A linear (bump) allocator for the scratch memory of a Step. Handing
+     * out memory is only moving an offset forward, nothing is freed on
+     * its own; Reset frees everything at once.
+     *
+     * When a Step needs more than the arena holds, extra blocks are taken
+     * from the heap. Reset then replaces the blocks by a single one large
+     * enough for the busiest Step so far, so once the simulation settles
+     * Steps no longer touch the heap at all. A limit caps the size of that
+     * block; Steps needing more keep borrowing from the heap, and give it
+     * back on the next Reset.
+     *
+     * Allocate may be called from several threads at once, Reset may not.
+     */
+    class FrameArena
+    {
+    public:
+        FrameArena();
+        ~FrameArena();
+
+        FrameArena(const FrameArena&) = delete;
+        FrameArena& operator=(const FrameArena&) = delete;
+
+        /**
+         * Returns Size bytes aligned to Alignment (at most 16), valid until
+         * the next Reset.
+         */
+        void* Allocate(size_t Size, size_t Alignment);
+
+        /** Takes back everything handed out since the last Reset. */
+        void Reset();
+
+        /** Sets the most bytes the arena keeps between Steps, no limit if zero. */
+        void SetLimit(size_t Bytes);
+
+        /** Returns the bytes handed out since the last Reset. */
+        size_t GetUsed() const;
+
+        /** Returns the most bytes ever handed out between two Resets. */
+        size_t GetHighWater() const;
+
+        /** Returns the number of blocks taken from the heap since the last Reset. */
+        unsigned GetHeapBlocks() const { return HeapBlocks; }
+
+    private:
+        /** A chunk of memory, its header is followed by Size bytes of data. */
+        struct Block
+        {
+            Block* Next;
+            size_t Size;
+            std::atomic<size_t> Used;
+
+            char* GetData() { return reinterpret_cast<char*>(this) + HeaderSize; }
+        };
+
+        /** Holds the size of a Block header, rounded up so data starts on a cache line. */
+        const static size_t HeaderSize = (sizeof(Block) + 63) & ~(size_t)63;
+
+        /** Holds the smallest block taken from the heap. */
+        const static size_t MinBlockSize = 64 * 1024;
+
+        /**
+         * Makes sure the current block is not Full anymore and has room
+         * for at least Size bytes, returns the current block.
+         */
+        Block* Grow(Block* Full, size_t Size);
+
+        static Block* NewBlock(size_t Size);
+
+        void FreeBlocks();
+
+        /** Holds the block memory is handed out from, it links to the full ones. */
+        std::atomic<Block*> Current;
+
+        /** Serializes the taking of new blocks. */
+        std::mutex GrowLock;
+
+        size_t Limit = 0;
+
+        /** Holds the most bytes handed out between two Resets, up to the last Reset. */
+        size_t HighWater = 0;
+
+        unsigned HeapBlocks = 0;
+    };
+
+    /**
+     * Lets standard containers take their memory from a FrameArena.
+     * Freeing is a no-op, the memory goes back on the next Reset. A
+     * default constructed allocator has no arena and uses the heap.
+     */
+    template<typename T>
+    class FrameAllocator
+    {
+    public:
+        typedef T value_type;
+        typedef std::true_type propagate_on_container_copy_assignment;
+        typedef std::true_type propagate_on_container_move_assignment;
+        typedef std::true_type propagate_on_container_swap;
+
+        FrameAllocator() : Arena(nullptr) {}
+        explicit FrameAllocator(FrameArena& arena) : Arena(&arena) {}
+
+        template<typename U>
+        FrameAllocator(const FrameAllocator<U>& other) : Arena(other.Arena) {}
+
+        T* allocate(size_t Count)
+        {
+            if (Arena == nullptr)
+                return static_cast<T*>(::operator new(Count * sizeof(T)));
+
+            return static_cast<T*>(Arena->Allocate(Count * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T* Pointer, size_t)
+        {
+            if (Arena == nullptr)
+                ::operator delete(Pointer);
+        }
+
+        template<typename U>
+        bool operator==(const FrameAllocator<U>& other) const { return Arena == other.Arena; }
+
+        template<typename U>
+        bool operator!=(const FrameAllocator<U>& other) const { return Arena != other.Arena; }
+
+        FrameArena* Arena;
+    };
+
+    template<typename T>
+    using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+    /**
+     * Empties the vector and has it take its memory from the arena from
+     * now on (from the heap if arena is null). Whatever it held before is
+     * dropped without being read, so the arena it came from may already
+     * have been Reset. Only meant for elements with nothing to destroy.
+     */
+    template<typename T>
+    void AttachToArena(FrameVector<T>& Vector, FrameArena* arena)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "Arena elements are never destroyed");
+        Vector = (arena != nullptr) ? FrameVector<T>(FrameAllocator<T>(*arena)) : FrameVector<T>();
+    }
+}
@@ -0,0 +1,109 @@
+#include <assert.h>
+#include "IndexedHeap.h"
+
+namespace CrunchMath {
+
+    void IndexedHeap::Reset(unsigned Count)
+    {
+        // Items in order with equal priorities already make a heap.
+        Heap.resize(Count);
+        Positions.resize(Count);
+        Priorities.assign(Count, 0.0f);
+
+        for (unsigned i = 0; i < Count; i++)
+        {
+            Heap[i] = i;
+            Positions[i] = i;
+        }
+    }
+
+    void IndexedHeap::SetArena(FrameArena* arena)
+    {
+        AttachToArena(Heap, arena);
+        AttachToArena(Positions, arena);
+        AttachToArena(Priorities, arena);
+    }
+
+    void IndexedHeap::Update(unsigned Item, float Priority)
+    {
+        assert(Item < Priorities.size());
+
+        float Old = Priorities[Item];
+        Priorities[Item] = Priority;
+
+        if (Priority > Old)
+            SiftUp(Positions[Item]);
+        else if (Priority < Old)
+            SiftDown(Positions[Item]);
+    }
+
+    unsigned IndexedHeap::Top() const
+    {
+        assert(!Heap.empty());
+        return Heap[0];
+    }
+
+    float IndexedHeap::TopPriority() const
+    {
+        assert(!Heap.empty());
+        return Priorities[Heap[0]];
+    }
+
+    bool IndexedHeap::Empty() const
+    {
+        return Heap.empty();
+    }
+
+    bool IndexedHeap::Before(unsigned a, unsigned b) const
+    {
+        if (Priorities[a] != Priorities[b])
+            return Priorities[a] > Priorities[b];
+
+        return a < b;
+    }
+
+    void IndexedHeap::SiftUp(unsigned Position)
+    {
+        unsigned Item = Heap[Position];
+        while (Position > 0)
+        {
+            unsigned Parent = (Position - 1) / 2;
+            if (!Before(Item, Heap[Parent]))
+                break;
+
+            Place(Position, Heap[Parent]);
+            Position = Parent;
+        }
+
+        Place(Position, Item);
+    }
+
+    void IndexedHeap::SiftDown(unsigned Position)
+    {
+        unsigned Item = Heap[Position];
+        unsigned Count = (unsigned)Heap.size();
+        while (true)
+        {
+            unsigned Child = Position * 2 + 1;
+            if (Child >= Count)
+                break;
+
+            if (Child + 1 < Count && Before(Heap[Child + 1], Heap[Child]))
+                Child++;
+
+            if (!Before(Heap[Child], Item))
+                break;
+
+            Place(Position, Heap[Child]);
+            Position = Child;
+        }
+
+        Place(Position, Item);
+    }
+
+    void IndexedHeap::Place(unsigned Position, unsigned Item)
+    {
+        Heap[Position] = Item;
+        Positions[Item] = Position;
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "FrameArena.h"
+
+namespace CrunchMath {
+
+    /**
+     * A max-heap over the items 0 to Count - 1, each with a priority that
+     * can be raised or lowered in place. The ContactResolver keeps its
+     * Contacts in one, so finding the worst contact does not need a pass
+     * over all of them after every resolution.
+     *
+     * Items with equal priority come out lowest item first, which is the
+     * order a linear search for the largest value would find them in.
+     */
+    class IndexedHeap
+    {
+    public:
+        /** Fills the heap with the items 0 to Count - 1, all with priority 0. */
+        void Reset(unsigned Count);
+
+        /** Changes the priority of an item and moves it to its place. */
+        void Update(unsigned Item, float Priority);
+
+        /** Returns the item with the highest priority. */
+        unsigned Top() const;
+
+        /** Returns the highest priority. */
+        float TopPriority() const;
+
+        bool Empty() const;
+
+        /**
+         * Has the heap take its memory from the arena (the heap if null)
+         * and empties it.
+         */
+        void SetArena(FrameArena* arena);
+
+    private:
+        /** Returns whether item a comes out before item b. */
+        bool Before(unsigned a, unsigned b) const;
+
+        void SiftUp(unsigned Position);
+
+        void SiftDown(unsigned Position);
+
+        void Place(unsigned Position, unsigned Item);
+
+        /** Holds the items, in heap order. */
+        FrameVector<unsigned> Heap;
+
+        /** Holds the place of each item in Heap. */
+        FrameVector<unsigned> Positions;
+
+        FrameVector<float> Priorities;
+    };
+}
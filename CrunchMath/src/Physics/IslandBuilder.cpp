@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <assert.h>
+#include "IslandBuilder.h"
+
+namespace CrunchMath {
+
+    const unsigned IslandBuilder::NoSlot;
+
+    bool IslandBuilder::CanMove(const Body* body)
+    {
+        return body != nullptr && body->GetInverseMass() > 0.0f;
+    }
+
+    unsigned IslandBuilder::FindSlot(const Body* body) const
+    {
+        if (!CanMove(body))
+            return NoSlot;
+
+        return (unsigned)(std::lower_bound(Bodies.begin(), Bodies.end(), body) - Bodies.begin());
+    }
+
+    unsigned IslandBuilder::FindRoot(unsigned Slot)
+    {
+        while (Parents[Slot] != Slot)
+        {
+            Parents[Slot] = Parents[Parents[Slot]];
+            Slot = Parents[Slot];
+        }
+
+        return Slot;
+    }
+
+    void IslandBuilder::Union(unsigned a, unsigned b)
+    {
+        a = FindRoot(a);
+        b = FindRoot(b);
+        if (a == b)
+            return;
+
+        // Hang the smaller set under the bigger one, to keep paths short.
+        if (SetSizes[a] < SetSizes[b])
+            std::swap(a, b);
+
+        Parents[b] = a;
+        SetSizes[a] += SetSizes[b];
+    }
+
+    void IslandBuilder::SetArena(FrameArena* arena)
+    {
+        AttachToArena(Bodies, arena);
+        AttachToArena(Parents, arena);
+        AttachToArena(SetSizes, arena);
+        AttachToArena(RootIslands, arena);
+        AttachToArena(ContactIslands, arena);
+        AttachToArena(SortedContacts, arena);
+        AttachToArena(Islands, arena);
+        AttachToArena(IslandBodies, arena);
+    }
+
+    unsigned IslandBuilder::Build(Contact* Contacts, unsigned ContactCount)
+    {
+        Islands.clear();
+        IslandBodies.clear();
+        Bodies.clear();
+
+        if (ContactCount == 0)
+            return 0;
+
+        for (unsigned i = 0; i < ContactCount; i++)
+        {
+            for (unsigned b = 0; b < 2; b++)
+            {
+                if (CanMove(Contacts[i].body[b]))
+                    Bodies.push_back(Contacts[i].body[b]);
+            }
+        }
+
+        std::sort(Bodies.begin(), Bodies.end());
+        Bodies.erase(std::unique(Bodies.begin(), Bodies.end()), Bodies.end());
+        unsigned BodyCount = (unsigned)Bodies.size();
+
+        Parents.resize(BodyCount);
+        SetSizes.assign(BodyCount, 1);
+        for (unsigned i = 0; i < BodyCount; i++)
+            Parents[i] = i;
+
+        for (unsigned i = 0; i < ContactCount; i++)
+        {
+            unsigned One = FindSlot(Contacts[i].body[0]);
+            unsigned Two = FindSlot(Contacts[i].body[1]);
+            if (One != NoSlot && Two != NoSlot)
+                Union(One, Two);
+        }
+
+        // Number the islands in the order their first contact comes in,
+        // so the result does not depend on where the bodies are in memory.
+        // Contacts between bodies that cannot move share one island.
+        RootIslands.assign(BodyCount, NoSlot);
+        ContactIslands.resize(ContactCount);
+        unsigned StaticIsland = NoSlot;
+
+        for (unsigned i = 0; i < ContactCount; i++)
+        {
+            unsigned Slot = FindSlot(Contacts[i].body[0]);
+            if (Slot == NoSlot)
+                Slot = FindSlot(Contacts[i].body[1]);
+
+            unsigned& IslandIndex = (Slot == NoSlot) ? StaticIsland : RootIslands[FindRoot(Slot)];
+            if (IslandIndex == NoSlot)
+            {
+                IslandIndex = (unsigned)Islands.size();
+                Islands.push_back(Island());
+                Islands.back().ContactCount = 0;
+                Islands.back().BodyCount = 0;
+            }
+
+            ContactIslands[i] = IslandIndex;
+            Islands[IslandIndex].ContactCount++;
+        }
+
+        for (unsigned i = 0; i < BodyCount; i++)
+            Islands[RootIslands[FindRoot(i)]].BodyCount++;
+
+        // Turn the counts into start offsets, then scatter the Contacts and
+        // the bodies into place. The scatter keeps their order.
+        unsigned FirstContact = 0, FirstBody = 0;
+        for (unsigned i = 0; i < Islands.size(); i++)
+        {
+            Islands[i].FirstContact = FirstContact;
+            Islands[i].FirstBody = FirstBody;
+            FirstContact += Islands[i].ContactCount;
+            FirstBody += Islands[i].BodyCount;
+
+            // Used as the fill cursors for now.
+            Islands[i].ContactCount = 0;
+            Islands[i].BodyCount = 0;
+        }
+
+        SortedContacts.resize(ContactCount);
+        for (unsigned i = 0; i < ContactCount; i++)
+        {
+            Island& island = Islands[ContactIslands[i]];
+            SortedContacts[island.FirstContact + island.ContactCount++] = Contacts[i];
+        }
+
+        std::copy(SortedContacts.begin(), SortedContacts.begin() + ContactCount, Contacts);
+
+        IslandBodies.resize(BodyCount);
+        for (unsigned i = 0; i < BodyCount; i++)
+        {
+            Island& island = Islands[RootIslands[FindRoot(i)]];
+            IslandBodies[island.FirstBody + island.BodyCount++] = Bodies[i];
+        }
+
+        return (unsigned)Islands.size();
+    }
+
+    unsigned IslandBuilder::GetIslandCount() const
+    {
+        return (unsigned)Islands.size();
+    }
+
+    const IslandBuilder::Island& IslandBuilder::GetIsland(unsigned index) const
+    {
+        assert(index < Islands.size());
+        return Islands[index];
+    }
+
+    Body* const* IslandBuilder::GetBodies() const
+    {
+        return IslandBodies.empty() ? nullptr : &IslandBodies[0];
+    }
+
+    bool IslandBuilder::Contains(const Body* body) const
+    {
+        if (!CanMove(body))
+            return false;
+
+        unsigned Slot = FindSlot(body);
+        return Slot < Bodies.size() && Bodies[Slot] == body;
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include "Contacts.h"
+#include "FrameArena.h"
+
+namespace CrunchMath {
+
+    /**
+     * Splits the Contacts of a Step into islands: sets of bodies that
+     * touch each other, directly or through other bodies. Contacts of
+     * different islands cannot affect each other, so each island can be
+     * handed to the ContactResolver on its own. The Resolver gets a lot
+     * faster on small sets, and a big pile no longer eats the iterations
+     * of a box resting somewhere else.
+     *
+     * Bodies that cannot move (infinite mass) do not join islands:
+     * everything lying on the same ground would otherwise be one island.
+     */
+    class IslandBuilder
+    {
+    public:
+        /** A range of the sorted Contacts and of the island bodies. */
+        struct Island
+        {
+            unsigned FirstContact;
+            unsigned ContactCount;
+
+            unsigned FirstBody;
+            unsigned BodyCount;
+        };
+
+        /**
+         * Finds the islands of the given Contacts, and reorders the
+         * Contacts so those of each island are next to each other.
+         * Contacts keep their order within an island, so the Contacts of
+         * a pair stay together. Returns the number of islands.
+         */
+        unsigned Build(Contact* Contacts, unsigned ContactCount);
+
+        /**
+         * Has the builder take its memory from the arena (the heap if
+         * null), forgetting the islands built so far.
+         */
+        void SetArena(FrameArena* arena);
+
+        unsigned GetIslandCount() const;
+
+        const Island& GetIsland(unsigned index) const;
+
+        /**
+         * Returns the bodies of the islands, the bodies of each island
+         * are next to each other as given by Island::FirstBody.
+         */
+        Body* const* GetBodies() const;
+
+        /** Returns whether the body is part of one of the islands. */
+        bool Contains(const Body* body) const;
+
+    private:
+        static bool CanMove(const Body* body);
+
+        /** Returns the slot of the given body, or NoSlot if it cannot move. */
+        unsigned FindSlot(const Body* body) const;
+
+        /** Returns the root of the set of a slot, halving the path on the way. */
+        unsigned FindRoot(unsigned Slot);
+
+        void Union(unsigned a, unsigned b);
+
+        const static unsigned NoSlot = 0xffffffff;
+
+        /** Holds the bodies that can move, sorted. A body's place in here is its slot. */
+        FrameVector<Body*> Bodies;
+
+        /** Holds the union-find parent of each slot. */
+        FrameVector<unsigned> Parents;
+
+        /** Holds the number of slots in each set, valid for roots only. */
+        FrameVector<unsigned> SetSizes;
+
+        /** Holds the island of each root slot, or NoSlot before it is numbered. */
+        FrameVector<unsigned> RootIslands;
+
+        /** Holds the island of each contact. */
+        FrameVector<unsigned> ContactIslands;
+
+        /** Holds the Contacts while they are being reordered. */
+        FrameVector<Contact> SortedContacts;
+
+        FrameVector<Island> Islands;
+
+        FrameVector<Body*> IslandBodies;
+    };
+}
@@ -0,0 +1,175 @@
+#include <assert.h>
+#include "JobSystem.h"
+
+namespace CrunchMath {
+
+    JobSystem::JobSystem()
+        :Pending(0)
+    {
+        Queues.push_back(new WorkerQueue());
+    }
+
+    JobSystem::~JobSystem()
+    {
+        StopThreads();
+
+        for (unsigned i = 0; i < Queues.size(); i++)
+            delete Queues[i];
+    }
+
+    void JobSystem::StopThreads()
+    {
+        {
+            std::lock_guard<std::mutex> Guard(WakeLock);
+            Quit = true;
+        }
+        WakeCondition.notify_all();
+
+        for (unsigned i = 0; i < Threads.size(); i++)
+            Threads[i].join();
+
+        Threads.clear();
+        Quit = false;
+    }
+
+    void JobSystem::SetThreadCount(unsigned count)
+    {
+        if (count == 0)
+            count = 1;
+
+        if (count == Queues.size())
+            return;
+
+        StopThreads();
+
+        for (unsigned i = 1; i < Queues.size(); i++)
+            delete Queues[i];
+        Queues.resize(1);
+
+        for (unsigned i = 1; i < count; i++)
+            Queues.push_back(new WorkerQueue());
+
+        for (unsigned i = 1; i < count; i++)
+            Threads.push_back(std::thread(&JobSystem::WorkerLoop, this, i));
+    }
+
+    unsigned JobSystem::GetThreadCount() const
+    {
+        return (unsigned)Queues.size();
+    }
+
+    void JobSystem::ParallelFor(unsigned Count, unsigned Grain, const Job& job)
+    {
+        if (Count == 0)
+            return;
+
+        if (Grain == 0)
+            Grain = 1;
+
+        // Nothing to share, skip the queues.
+        if (Queues.size() == 1 || Count <= Grain)
+        {
+            for (unsigned Begin = 0; Begin < Count; Begin += Grain)
+                job(Begin, (Count - Begin < Grain) ? Count : Begin + Grain, 0);
+            return;
+        }
+
+        unsigned RangeCount = (Count + Grain - 1) / Grain;
+        Pending = RangeCount;
+
+        // Deal the ranges out in turn, so each worker starts with a share.
+        for (unsigned i = 0; i < RangeCount; i++)
+        {
+            Range range;
+            range.Begin = i * Grain;
+            range.End = (Count - range.Begin < Grain) ? Count : range.Begin + Grain;
+            range.Work = &job;
+
+            WorkerQueue& Queue = *Queues[i % Queues.size()];
+            std::lock_guard<std::mutex> Guard(Queue.Lock);
+            Queue.Ranges.push_back(range);
+        }
+
+        {
+            std::lock_guard<std::mutex> Guard(WakeLock);
+            Generation++;
+        }
+        WakeCondition.notify_all();
+
+        RunJobs(0);
+
+        // Other workers may still be busy with the last ranges.
+        std::unique_lock<std::mutex> Guard(WakeLock);
+        DoneCondition.wait(Guard, [this] { return Pending == 0; });
+    }
+
+    void JobSystem::WorkerLoop(unsigned Worker)
+    {
+        unsigned Seen = 0;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> Guard(WakeLock);
+                WakeCondition.wait(Guard, [this, Seen] { return Quit || Generation != Seen; });
+
+                if (Quit)
+                    return;
+
+                Seen = Generation;
+            }
+
+            RunJobs(Worker);
+        }
+    }
+
+    void JobSystem::RunJobs(unsigned Worker)
+    {
+        Range range;
+        while (TakeRange(Worker, range))
+        {
+            (*range.Work)(range.Begin, range.End, Worker);
+
+            if (--Pending == 0)
+            {
+                // Take the lock, so the caller can't miss the notification
+                // between checking Pending and starting to wait.
+                std::lock_guard<std::mutex> Guard(WakeLock);
+                DoneCondition.notify_all();
+            }
+        }
+    }
+
+    bool JobSystem::TakeRange(unsigned Worker, Range& range)
+    {
+        unsigned QueueCount = (unsigned)Queues.size();
+
+        // Own work first, newest first, then the oldest work of the others.
+        for (unsigned i = 0; i < QueueCount; i++)
+        {
+            WorkerQueue& Queue = *Queues[(Worker + i) % QueueCount];
+            std::lock_guard<std::mutex> Guard(Queue.Lock);
+
+            if (Queue.Head == Queue.Ranges.size())
+                continue;
+
+            if (i == 0)
+            {
+                range = Queue.Ranges.back();
+                Queue.Ranges.pop_back();
+            }
+
+            else
+                range = Queue.Ranges[Queue.Head++];
+
+            if (Queue.Head == Queue.Ranges.size())
+            {
+                Queue.Ranges.clear();
+                Queue.Head = 0;
+            }
+
+            return true;
+        }
+
+        return false;
+    }
+}
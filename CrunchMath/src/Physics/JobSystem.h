@@ -0,0 +1,96 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+namespace CrunchMath {
+
+    /**
+     * A small work-stealing scheduler for the parallel loops of a World
+     * Step. ParallelFor cuts a range of items into jobs and deals them
+     * out over the queues of the workers. Each worker takes jobs from
+     * its own queue first, and steals from the others once it runs dry,
+     * so a worker stuck with slow jobs does not hold up the rest. The
+     * calling thread works along as worker 0.
+     *
+     * The jobs only depend on the range and the grain, never on the
+     * number of threads, and must not depend on each other. Code that
+     * keeps per worker scratch data uses the worker index passed to it.
+     */
+    class JobSystem
+    {
+    public:
+        /** A job works on the items [Begin, End) as the given worker. */
+        typedef std::function<void(unsigned Begin, unsigned End, unsigned Worker)> Job;
+
+        JobSystem();
+        ~JobSystem();
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        /**
+         * Sets the number of threads working on jobs, the calling thread
+         * included. One, the default, runs everything on the caller.
+         */
+        void SetThreadCount(unsigned count);
+
+        unsigned GetThreadCount() const;
+
+        /**
+         * Runs the job over the items 0 to Count - 1, in ranges of at
+         * most Grain items, and returns once all of them are done.
+         */
+        void ParallelFor(unsigned Count, unsigned Grain, const Job& job);
+
+    private:
+        struct Range
+        {
+            unsigned Begin;
+            unsigned End;
+            const Job* Work;
+        };
+
+        /**
+         * The jobs of a worker. The owner takes them from the back, thieves
+         * from Head on. Emptied queues start over at the front, so they
+         * keep their capacity and ParallelFor doesn't touch the heap.
+         */
+        struct WorkerQueue
+        {
+            std::mutex Lock;
+            std::vector<Range> Ranges;
+            unsigned Head = 0;
+        };
+
+        void StopThreads();
+
+        void WorkerLoop(unsigned Worker);
+
+        /** Runs jobs as the given worker until no queue has any left. */
+        void RunJobs(unsigned Worker);
+
+        /** Takes a job from the worker's own queue, or steals one. */
+        bool TakeRange(unsigned Worker, Range& range);
+
+        std::vector<std::thread> Threads;
+
+        /** Holds a queue per worker, worker 0 being the calling thread. */
+        std::vector<WorkerQueue*> Queues;
+
+        /** Holds the number of jobs of the current ParallelFor not done yet. */
+        std::atomic<unsigned> Pending;
+
+        std::mutex WakeLock;
+        std::condition_variable WakeCondition;
+        std::condition_variable DoneCondition;
+
+        /** Counts the ParallelFor calls, workers wake up when it changes. */
+        unsigned Generation = 0;
+
+        bool Quit = false;
+    };
+}
@@ -0,0 +1,124 @@
+#include <assert.h>
+#include <string.h>
+#include "ShapePool.h"
+
+namespace CrunchMath {
+
+    size_t ShapePool::ShapeKeyHash::operator()(const ShapeKey& Key) const
+    {
+        size_t Hash = (size_t)Key.Type;
+        for (unsigned i = 0; i < 3; i++)
+        {
+            unsigned Bits;
+            memcpy(&Bits, &Key.Size[i], sizeof(Bits));
+            Hash = Hash * 31 + Bits;
+        }
+
+        return Hash;
+    }
+
+    ShapePool::ShapeKey ShapePool::MakeKey(const cmShape& shape)
+    {
+        ShapeKey Key;
+        Key.Type = shape.GetType();
+        Key.Size[0] = Key.Size[1] = Key.Size[2] = 0.0f;
+
+        switch (Key.Type)
+        {
+        case cmShape::Type::s_Box: {
+            const Vec3& HalfSizes = static_cast<const cmBox&>(shape).GetHalfSizes();
+            Key.Size[0] = HalfSizes.x;
+            Key.Size[1] = HalfSizes.y;
+            Key.Size[2] = HalfSizes.z;
+            break;
+        }
+
+        case cmShape::Type::s_Sphere: {
+            Key.Size[0] = static_cast<const cmSphere&>(shape).GetRadius();
+            break;
+        }
+
+        default:
+            assert(false);
+            break;
+        }
+
+        return Key;
+    }
+
+    const cmShape* ShapePool::Share(const cmShape& shape)
+    {
+        ShapeKey Key = MakeKey(shape);
+
+        std::unordered_map<ShapeKey, PooledShape, ShapeKeyHash>::iterator it = Lookup.find(Key);
+        if (it != Lookup.end())
+        {
+            it->second.References++;
+            return it->second.Shape;
+        }
+
+        cmShape* Pooled = nullptr;
+        if (Key.Type == cmShape::Type::s_Box)
+        {
+            cmBox* Box;
+            if (!FreeBoxes.empty())
+            {
+                Box = FreeBoxes.back();
+                FreeBoxes.pop_back();
+            }
+
+            else
+            {
+                Boxes.push_back(cmBox());
+                Box = &Boxes.back();
+            }
+
+            Box->Set(Key.Size[0], Key.Size[1], Key.Size[2]);
+            Pooled = Box;
+        }
+
+        else
+        {
+            cmSphere* Sphere;
+            if (!FreeSpheres.empty())
+            {
+                Sphere = FreeSpheres.back();
+                FreeSpheres.pop_back();
+            }
+
+            else
+            {
+                Spheres.push_back(cmSphere());
+                Sphere = &Spheres.back();
+            }
+
+            Sphere->Set(Key.Size[0]);
+            Pooled = Sphere;
+        }
+
+        PooledShape Entry = { Pooled, 1 };
+        Lookup.emplace(Key, Entry);
+        return Pooled;
+    }
+
+    void ShapePool::Release(const cmShape* shape)
+    {
+        std::unordered_map<ShapeKey, PooledShape, ShapeKeyHash>::iterator it = Lookup.find(MakeKey(*shape));
+        assert(it != Lookup.end() && it->second.Shape == shape && it->second.References > 0);
+
+        if (--it->second.References > 0)
+            return;
+
+        if (it->first.Type == cmShape::Type::s_Box)
+            FreeBoxes.push_back(static_cast<cmBox*>(it->second.Shape));
+        else
+            FreeSpheres.push_back(static_cast<cmSphere*>(it->second.Shape));
+
+        Lookup.erase(it);
+    }
+
+    unsigned ShapePool::GetShapeCount() const
+    {
+        return (unsigned)Lookup.size();
+    }
+}
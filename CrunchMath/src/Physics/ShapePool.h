@@ -0,0 +1,72 @@
+#pragma once
+#include <deque>
+#include <unordered_map>
+#include <vector>
+#include "Collisions.h"
+
+namespace CrunchMath {
+
+    /**
+     * Holds the shapes of a World's bodies, one array per shape type.
+     * Bodies of equal shapes share a single pooled copy, so spawning a
+     * body of a size seen before allocates nothing. Pooled shapes are
+     * never changed or moved. Each one counts the bodies sharing it, and
+     * once the last of them lets go its place is handed to the next new
+     * shape of its type, so the pool only grows with the shapes in use.
+     */
+    class ShapePool
+    {
+    public:
+        /**
+         * Returns the pooled shape equal to the given one, copying it into
+         * the pool the first time such a shape is asked for.
+         */
+        const cmShape* Share(const cmShape& shape);
+
+        /**
+         * Lets go of a shape Share returned. The shape is recycled when
+         * nothing else shares it.
+         */
+        void Release(const cmShape* shape);
+
+        /** Returns the number of distinct shapes in use. */
+        unsigned GetShapeCount() const;
+
+    private:
+        /** Tells shapes apart by type and size. Spheres keep their radius in Size[0]. */
+        struct ShapeKey
+        {
+            cmShape::Type Type;
+            float Size[3];
+
+            bool operator==(const ShapeKey& other) const
+            {
+                return Type == other.Type && Size[0] == other.Size[0] &&
+                       Size[1] == other.Size[1] && Size[2] == other.Size[2];
+            }
+        };
+
+        struct ShapeKeyHash
+        {
+            size_t operator()(const ShapeKey& Key) const;
+        };
+
+        struct PooledShape
+        {
+            cmShape* Shape;
+            unsigned References;
+        };
+
+        static ShapeKey MakeKey(const cmShape& shape);
+
+        /** A deque grows in fixed chunks, so elements never move. */
+        std::deque<cmBox> Boxes;
+        std::deque<cmSphere> Spheres;
+
+        /** Holds the released shapes of each type, reused before the deques grow. */
+        std::vector<cmBox*> FreeBoxes;
+        std::vector<cmSphere*> FreeSpheres;
+
+        std::unordered_map<ShapeKey, PooledShape, ShapeKeyHash> Lookup;
+    };
+}
@@ -1,228 +1,580 @@
+#include <algorithm>
 #include "World.h"
 
 namespace CrunchMath {
 
-	World::World(Vec3 gravity)
-		:Gravity(gravity), Index(0)
+	//Builds the matrix Body::GetModelMatrix would give for the pose: the rotation of the
+	//unit quaternion q, as Mat4x4::Rotate sets it, scaled by Size and moved to Position.
+	//Model gets the 16 floats of the matrix, column by column.
+	static inline void BuildModelMatrix(float* Model, const Vec3& Position, const Quaternion& q, const Vec3& Size)
+	{
+		SIMD::Float4 Column0 = SIMD::Set(1.0f - (2.0f) * ((q.y * q.y) + (q.z * q.z)),
+			(2.0f) * ((q.x * q.y) + (q.w * q.z)), (2.0f) * ((q.x * q.z) - (q.w * q.y)), 0.0f);
+		SIMD::Float4 Column1 = SIMD::Set((2.0f) * ((q.x * q.y) - (q.w * q.z)),
+			1.0f - (2.0f) * ((q.x * q.x) + (q.z * q.z)), (2.0f) * ((q.y * q.z) + (q.w * q.x)), 0.0f);
+		SIMD::Float4 Column2 = SIMD::Set((2.0f) * ((q.x * q.z) + (q.w * q.y)),
+			(2.0f) * ((q.y * q.z) - (q.w * q.x)), 1.0f - (2.0f) * ((q.x * q.x) + (q.y * q.y)), 0.0f);
+
+		SIMD::Store(Model, SIMD::Mul(Column0, SIMD::Splat(Size.x)));
+		SIMD::Store(Model + 4, SIMD::Mul(Column1, SIMD::Splat(Size.y)));
+		SIMD::Store(Model + 8, SIMD::Mul(Column2, SIMD::Splat(Size.z)));
+		SIMD::Store(Model + 12, SIMD::SetW(Position.Load(), 1.0f));
+	}
+
+	//Returns the part of an iteration budget an island of IslandContacts out of TotalContacts
+	//gets, rounded up so that every island has at least one iteration.
+	static inline uint32_t IslandShare(uint32_t Budget, unsigned IslandContacts, unsigned TotalContacts)
 	{
-		Parent = true;
-		memset(FreeStack, true, MaxNumberOfBodies);
-		CData.ptrContactArray = Contacts;
-		Resolver.SetIterations(5000, 100);
-		m_pNext = nullptr;
+		return (uint32_t)(((uint64_t)Budget * IslandContacts + TotalContacts - 1) / TotalContacts);
 	}
 
-	World::World(Vec3 gravity, bool parent)
-		:Gravity(gravity), Index(0)
+	World::World(Vec3 gravity)
+		:Gravity(gravity)
 	{
-		//No need to set collision Data here since its always going to be handled by the Parent gameWorld.
-		//Same for ContactResolver. it is going to be handled by the parent game world...
-		this->Parent = parent;
-		memset(FreeStack, true, MaxNumberOfBodies);
-		m_pNext = nullptr;
-    }
+		Resolvers.resize(1);
+		Resolvers[0].SetIterations(PositionIterations, VelocityIterations);
+	}
 
 	World::~World()
 	{
-		//Only Parent World Nodes/Blocks can delete its children
-		if (Parent)
+		for (unsigned i = 0; i < Blocks.size(); i++)
+			delete Blocks[i];
+	}
+
+	Body* World::GetSlotBody(unsigned Id) const
+	{
+		return Blocks[Id / BodyStore::Capacity]->Bodies + Id % BodyStore::Capacity;
+	}
+
+	Body* World::CreateBody(const cmShape* primitive, Body::BodyType type)
+	{
+		//Reuse the most recently destroyed slot of the type, or else hand out
+		//a new one, adding a block when the last one of the type is full.
+		unsigned Id = FirstFree[type];
+		if (Id != NoSlot)
+			FirstFree[type] = Slots[Id].Link;
+
+		else
 		{
-			World* ptr = this->m_pNext;
-			while (ptr != nullptr)
+			unsigned Last = LastBlock[type];
+			if (Last == NoSlot || Blocks[Last]->Used == BodyStore::Capacity)
 			{
-				World* Hold = ptr;
-				ptr = ptr->m_pNext;
-                delete Hold;
+				Last = (unsigned)Blocks.size();
+
+				BodyBlock* Block = new BodyBlock();
+				Block->Type = type;
+				for (unsigned i = 0; i < BodyStore::Capacity; i++)
+				{
+					Block->Bodies[i].Bind(&Block->Store, i);
+					Block->Bodies[i].Id = Last * BodyStore::Capacity + i;
+					Block->Bodies[i].Type = type;
+				}
+
+				Blocks.push_back(Block);
+				LastBlock[type] = Last;
+
+				BodySlot NewSlot = { 0, 0 };
+				Slots.resize(Slots.size() + BodyStore::Capacity, NewSlot);
 			}
+
+			Id = Last * BodyStore::Capacity + Blocks[Last]->Used++;
+		}
+
+		//Static and kinematic bodies keep the infinite mass of a fresh slot,
+		//and aren't pulled by gravity. Kinematic ones keep their Velocity.
+		Body* newbody = GetSlotBody(Id);
+		if (type == Body::bt_Dynamic)
+		{
+			newbody->SetAcceleration(Gravity);
+			newbody->SetCanSleep(true);
+		}
+
+		else if (type == Body::bt_Kinematic)
+			newbody->SetDamping(1.0f, 1.0f);
+
+		newbody->Primitive = Shapes.Share(*primitive);
+
+		/* Its easy to detect whats a Boxand whats a Square by checking the
+		 * z-axis of the Size vector. so therefore no other enum shape for
+		 * squares would be implemented. Spheres get their diameter on all axes.
+		 */
+		if (primitive->GetType() == cmShape::Type::s_Box)
+			newbody->Size = static_cast<const cmBox*>(newbody->Primitive)->GetHalfSizes() * 2;
+		else
+		{
+			float Radius = static_cast<const cmSphere*>(newbody->Primitive)->GetRadius();
+			newbody->Size = Vec3(Radius * 2, Radius * 2, Radius * 2);
 		}
-    }
 
-	Body* World::CreateBody(cmShape* primitive)
+		Slots[Id].Link = (unsigned)LiveBodies.size();
+		LiveBodies.push_back(newbody);
+		BPhase.Insert(newbody);
+
+		return newbody;
+	}
+
+	void World::DestroyBody(Body* body)
+	{
+		assert(body != nullptr && body->Id < Slots.size() && GetSlotBody(body->Id) == body);
+		unsigned Id = body->Id;
+
+		BPhase.Remove(body);
+		Cache.Remove(body);
+
+		//Fill the gap in LiveBodies with the last live body.
+		unsigned Dense = Slots[Id].Link;
+		LiveBodies[Dense] = LiveBodies.back();
+		Slots[LiveBodies[Dense]->Id].Link = Dense;
+		LiveBodies.pop_back();
+
+		Shapes.Release(body->Primitive);
+		body->Primitive = nullptr;
+		body->Bind(body->Store, body->Slot);
+
+		Slots[Id].Generation++;
+		Slots[Id].Link = FirstFree[body->Type];
+		FirstFree[body->Type] = Id;
+	}
+
+	void World::DestroyBody(BodyHandle handle)
+	{
+		Body* body = GetBody(handle);
+		if (body != nullptr)
+			DestroyBody(body);
+	}
+
+	BodyHandle World::GetHandle(const Body* body) const
+	{
+		BodyHandle handle;
+		handle.Index = body->Id;
+		handle.Generation = Slots[body->Id].Generation;
+		return handle;
+	}
+
+	Body* World::GetBody(BodyHandle handle) const
+	{
+		if (handle.Index >= Slots.size() || Slots[handle.Index].Generation != handle.Generation)
+			return nullptr;
+
+		//Slots of a block that were never handed out.
+		if (handle.Index % BodyStore::Capacity >= Blocks[handle.Index / BodyStore::Capacity]->Used)
+			return nullptr;
+
+		return GetSlotBody(handle.Index);
+	}
+
+	void World::UpdateStaticBody(Body* body)
+	{
+		assert(body->GetType() == Body::bt_Static);
+		body->CalculateDerivedData();
+		BPhase.UpdateStatic(body);
+	}
+
+	void World::SetIterations(uint32_t Position, uint32_t Velocity)
+	{
+		PositionIterations = Position;
+		VelocityIterations = Velocity;
+		for (unsigned i = 0; i < Resolvers.size(); i++)
+			Resolvers[i].SetIterations(Position, Velocity);
+	}
+
+	void World::SetBroadPhase(BroadPhase::Type type)
+	{
+		BPhase.SetType(type);
+	}
+
+	void World::SetBroadPhaseCellSize(float size)
+	{
+		BPhase.SetCellSize(size);
+	}
+
+	void World::SetWarmStarting(bool enabled)
+	{
+		WarmStarting = enabled;
+		Cache.Clear();
+	}
+
+	void World::SetSleeping(bool enabled)
+	{
+		Sleeping = enabled;
+	}
+
+	void World::SetSolver(ContactResolver::SolverType type)
+	{
+		for (unsigned i = 0; i < Resolvers.size(); i++)
+			Resolvers[i].SetSolverType(type);
+	}
+
+	void World::SetThreadCount(unsigned count)
+	{
+		Jobs.SetThreadCount(count);
+
+		//New Resolvers take over the settings of the first one.
+		Resolvers.resize(Jobs.GetThreadCount(), Resolvers[0]);
+	}
+
+	void World::SetMaxContacts(unsigned count)
+	{
+		MaxContacts = count;
+	}
+
+	void World::SetPairFilter(PairFilter filter)
+	{
+		Filter = filter;
+	}
+
+	void World::ReserveContacts(unsigned count)
+	{
+		Contacts.reserve(count);
+	}
+
+	void World::SetFrameArenaLimit(size_t bytes)
+	{
+		Arena.SetLimit(bytes);
+	}
+
+	void World::SetTransformSnapshots(bool enabled)
+	{
+		KeepSnapshots = enabled;
+		if (enabled)
+			return;
+
+		std::lock_guard<std::mutex> Lock(SnapshotLock);
+		Snapshots[0] = TransformSnapshot();
+		Snapshots[1] = TransformSnapshot();
+	}
+
+	void World::InterpolateTransforms(float Alpha, std::vector<Mat4x4>& Models, std::vector<BodyHandle>* Handles) const
+	{
+		static_assert(sizeof(Mat4x4) % sizeof(float) == 0, "Mat4x4 must be a whole number of floats");
+
+		//Step only swaps the snapshots under the lock, so the front one can't
+		//change while it is read.
+		std::lock_guard<std::mutex> Lock(SnapshotLock);
+		const TransformSnapshot& Snapshot = Snapshots[FrontSnapshot];
+
+		unsigned Count = (unsigned)Snapshot.Handles.size();
+		Models.resize(Count);
+		if (Handles != nullptr)
+			*Handles = Snapshot.Handles;
+
+		if (Count == 0)
+			return;
+
+		InterpolateSnapshot(Snapshot, Alpha, Models[0].Matrix[0], sizeof(Mat4x4) / sizeof(float));
+		for (unsigned i = 0; i < Count; i++)
+			Models[i].RotationMatrix = false;
+	}
+
+	void World::InterpolateTransforms(float Alpha, std::vector<float>& Models, std::vector<BodyHandle>* Handles) const
 	{
-		if (Empty())
+		std::lock_guard<std::mutex> Lock(SnapshotLock);
+		const TransformSnapshot& Snapshot = Snapshots[FrontSnapshot];
+
+		unsigned Count = (unsigned)Snapshot.Handles.size();
+		Models.resize((size_t)Count * 16);
+		if (Handles != nullptr)
+			*Handles = Snapshot.Handles;
+
+		if (Count == 0)
+			return;
+
+		InterpolateSnapshot(Snapshot, Alpha, Models.data(), 16);
+	}
+
+	void World::InterpolateSnapshot(const TransformSnapshot& Snapshot, float Alpha, float* Models, size_t Stride) const
+	{
+		unsigned Count = (unsigned)Snapshot.Handles.size();
+
+		//A batch at a time, so the blended orientations fit on the stack.
+		const unsigned BatchSize = 64;
+		Quaternion Orientations[BatchSize];
+		for (unsigned Begin = 0; Begin < Count; Begin += BatchSize)
 		{
-			Stack[0].SetAcceleration(Gravity);
-			Body* newbody = Stack + Index;
+			unsigned BatchCount = (Count - Begin < BatchSize) ? Count - Begin : BatchSize;
+			Nlerp(&Snapshot.PreviousOrientations[Begin], &Snapshot.Orientations[Begin], Orientations, BatchCount, Alpha);
 
-			switch (primitive->GetType())
+			for (unsigned i = 0; i < BatchCount; i++)
 			{
-			case cmShape::Type::s_Box: {
-				newbody->Primitive = new cmBox();
-				Vec3 HalfSize = *(Vec3*)primitive->GetHalfSize();
-				/* Its easy to detect whats a Boxand whats a Square by checking the
-				 * z-axis of the Size vector. so therefore no other enum shape for
-				 * squares would be implemented  (Check s_Shere comments below)
-				 */
-				newbody->Size = HalfSize * 2;
-				newbody->Primitive->Set(HalfSize.x, HalfSize.y, HalfSize.z);
-				break;
+				unsigned Entry = Begin + i;
+				Vec3 Position = Snapshot.PreviousPositions[Entry] * (1.0f - Alpha) + Snapshot.Positions[Entry] * Alpha;
+				BuildModelMatrix(Models + Entry * Stride, Position, Orientations[i], Snapshot.Sizes[Entry]);
 			}
- 
-			case cmShape::Type::s_Sphere: {
-				newbody->Primitive = new cmSphere();
-                float Radius = *(float*)primitive->GetHalfSize();
-				//Assuming its a Sphere....Note there would be a cirlce enum type later.
-				//given the facts that circles are 2D while Spheres are 3D.
-				newbody->Size = Vec3(Radius * 2, Radius * 2, Radius * 2);
-				newbody->Primitive->Set(Radius);
-				break;
-			}
- 
-			default:
-				 std::cerr << "Shape Type Does not Exist" << std::endl; assert(false);
-				break;
-			}
- 
-			newbody->m_pNext = nullptr;
-			FreeStack[0] = false;
-			Index++;
-		    return newbody;
 		}
+	}
 
-		else if (Index == Size)
+	void World::FindContacts(unsigned PairCount)
+	{
+		const unsigned MaxPerPair = CollisionDetector::MaxContactsPerPair;
+
+		//Every batch of pairs writes into its own part of PairContacts, and the
+		//batches are copied over in order afterwards. That way the Contacts come
+		//out the same however the batches were shared out over the threads.
+		//The detector sets every field of the Contacts it writes, so their
+		//storage is taken from the arena as it is.
+		unsigned BatchCount = (PairCount + PairBatchSize - 1) / PairBatchSize;
+		PairContacts = static_cast<Contact*>(Arena.Allocate(PairCount * MaxPerPair * sizeof(Contact), alignof(Contact)));
+		BatchContactCounts = static_cast<unsigned*>(Arena.Allocate(BatchCount * sizeof(unsigned), alignof(unsigned)));
+
+		Jobs.ParallelFor(BatchCount, 1, [this, PairCount, MaxPerPair](unsigned Begin, unsigned End, unsigned /*Worker*/)
 		{
-			bool FoundSpace = false;
-			for (int i = 0; i < Size; i++)
+			for (unsigned Batch = Begin; Batch < End; Batch++)
 			{
-				if (FreeStack[i])
-				{
-					Stack[i].SetAcceleration(Gravity);
-
-					Body* newbody = Stack + i;
+				unsigned First = Batch * PairBatchSize;
+				unsigned Count = (PairCount - First < PairBatchSize) ? PairCount - First : PairBatchSize;
 
-					switch (primitive->GetType())
-					{
-					case cmShape::Type::s_Box: {
-						newbody->Primitive = new cmBox();
-						Vec3 HalfSize = *(Vec3*)primitive->GetHalfSize();
-						/* Its easy to detect whats a Boxand whats a Square by checking the
-					     * z-axis of the Size vector. so therefore no other enum shape for
-					     * squares would be implemented  (Check s_Shere comments below)
-						 */
-						newbody->Size = HalfSize * 2;
-						newbody->Primitive->Set(HalfSize.x, HalfSize.y, HalfSize.z);
-						break;
-					}
-		 
-					case cmShape::Type::s_Sphere: {
-						newbody->Primitive = new cmSphere();
-						float Radius = *(float*)primitive->GetHalfSize();
-					    /*Assuming its a Sphere....Note there would be a cirlce enum type later.
-					     * given the facts that circles are 2D while Spheres are 3D.
-						 */
-					    newbody->Size = Vec3(Radius * 2, Radius * 2, Radius * 2);
-						newbody->Primitive->Set(Radius);
-						break;
-					}
-		 
-					default:
-						 std::cerr << "Shape Type Does not Exist" << std::endl; assert(false);
-						break;
-					}
-					FreeStack[i] = false;
+				CollisionData Data;
+				Data.ptrContactArray = &PairContacts[First * MaxPerPair];
+				Data.Reset(Count * MaxPerPair);
+				Data.Friction = CData.Friction;
+				Data.Restitution = CData.Restitution;
+				Data.Tolerance = CData.Tolerance;
 
-					return newbody;
-				}
+				CollisionDetector::Collision(&PotentialContacts[First], Count, &Data);
+				BatchContactCounts[Batch] = Data.ContactCount;
 			}
-			
-			if (!FoundSpace)
-			{
-				if (m_pNext == nullptr)
-				{
-					//subsequent World blocks/nodes created from here are children 
-					m_pNext = new World(Gravity, false);
-					Body* newbody = m_pNext->CreateBody(primitive);
-
-					int i = Index - 1;
-					Body* Previous = Stack + i;
-					Previous->m_pNext = newbody;
-					
-					return newbody;
-				}
+		});
 
-				else
-				{
-					Body* newbody = m_pNext->CreateBody(primitive);
+		unsigned Generated = 0;
+		for (unsigned Batch = 0; Batch < BatchCount; Batch++)
+			Generated += BatchContactCounts[Batch];
 
-					return newbody;
-				}
-			}
+		unsigned Kept = (MaxContacts > 0 && Generated > MaxContacts) ? MaxContacts : Generated;
+		Stats.DroppedContacts = Generated - Kept;
+		Stats.TotalDroppedContacts += Stats.DroppedContacts;
+
+		Contacts.resize(Kept);
+		unsigned Filled = 0;
+		for (unsigned Batch = 0; Batch < BatchCount && Filled < Kept; Batch++)
+		{
+			unsigned Count = BatchContactCounts[Batch];
+			if (Count > Kept - Filled)
+				Count = Kept - Filled;
+
+			Contact* Source = &PairContacts[Batch * PairBatchSize * MaxPerPair];
+			std::copy(Source, Source + Count, Contacts.begin() + Filled);
+			Filled += Count;
 		}
+	}
 
-		else
+	void World::CaptureTransforms(bool End)
+	{
+		//Only the Step writes the back snapshot, and only the Step moves
+		//FrontSnapshot, so the back one is read here without the lock.
+		TransformSnapshot& Snapshot = Snapshots[1 - FrontSnapshot];
+		unsigned Count = (unsigned)LiveBodies.size();
+
+		if (!End)
 		{
-		   Stack[Index].SetAcceleration(Gravity);
+			Snapshot.Handles.resize(Count);
+			Snapshot.Sizes.resize(Count);
+			Snapshot.PreviousPositions.resize(Count);
+			Snapshot.PreviousOrientations.resize(Count);
+			Snapshot.Positions.resize(Count);
+			Snapshot.Orientations.resize(Count);
+		}
 
-		   Body* newbody = Stack + Index;
+		//No bodies come or go during a Step, so the entries of its end line
+		//up with those of its start.
+		assert(Snapshot.Handles.size() == Count);
 
-			switch (primitive->GetType())
+		Jobs.ParallelFor(Count, 256, [this, &Snapshot, End](unsigned Begin, unsigned Finish, unsigned /*Worker*/)
+		{
+			for (unsigned i = Begin; i < Finish; i++)
 			{
-			case cmShape::Type::s_Box: {
-				newbody->Primitive = new cmBox();
-				Vec3 HalfSize = *(Vec3*)primitive->GetHalfSize();
-			    /* Its easy to detect whats a Boxand whats a Square by checking the
-				 * z-axis of the Size vector. so therefore no other enum shape for
-				 * squares would be implemented  (Check s_Shere comments below)*/
-				newbody->Size = HalfSize * 2;
-				newbody->Primitive->Set(HalfSize.x, HalfSize.y, HalfSize.z);
-				break;
-			}
+				const Body* body = LiveBodies[i];
+				Vec3& Position = End ? Snapshot.Positions[i] : Snapshot.PreviousPositions[i];
+				Quaternion& Orientation = End ? Snapshot.Orientations[i] : Snapshot.PreviousOrientations[i];
 
-			case cmShape::Type::s_Sphere: {
-				newbody->Primitive = new cmSphere();
-				float Radius = *(float*)primitive->GetHalfSize();
-				/* Assuming its a Sphere....Note there would be a cirlce enum type later.
-				 * given the facts that circles are 2D while Spheres are 3D.*/
-			    newbody->Size = Vec3(Radius * 2, Radius * 2, Radius * 2);
-				newbody->Primitive->Set(Radius);
-				break;
+				Position = body->GetPosition();
+				body->GetOrientation(Orientation);
+				if (!End)
+				{
+					Snapshot.Handles[i] = GetHandle(body);
+					Snapshot.Sizes[i] = body->Size;
+				}
 			}
+		});
 
-			default:
-				 std::cerr << "Shape Type Does not Exist" << std::endl; assert(false);
-				break;
-			}
-			
-		   int i = Index - 1;
-		   Body* Previous = Stack + i;
-		   Previous->m_pNext = newbody;
-		   newbody->m_pNext = nullptr;
-
-		   FreeStack[Index] = false;
-		   Index++;
-		   return newbody;
+		if (End)
+		{
+			std::lock_guard<std::mutex> Lock(SnapshotLock);
+			FrontSnapshot = 1 - FrontSnapshot;
 		}
 	}
 
-	void World::SetIterations(uint32_t Position, uint32_t Velocity)
+	void World::UpdateSleep()
 	{
-		Resolver.SetIterations(Position, Velocity);
+		//An island sleeps as a whole or not at all, a body dropping out of
+		//a pile that still moves would only be woken again by its neighbours.
+		Body* const* IslandBodies = Islands.GetBodies();
+		for (unsigned i = 0; i < Islands.GetIslandCount(); i++)
+		{
+			const IslandBuilder::Island& island = Islands.GetIsland(i);
+			Body* const* Bodies = IslandBodies + island.FirstBody;
+
+			bool Quiet = true;
+			for (unsigned b = 0; b < island.BodyCount && Quiet; b++)
+				Quiet = Bodies[b]->GetCanSleep() && Bodies[b]->GetMotion() < SleepEpsilon;
+
+			if (Quiet)
+			{
+				for (unsigned b = 0; b < island.BodyCount; b++)
+					Bodies[b]->SetAwake(false);
+			}
+		}
+
+		Jobs.ParallelFor((unsigned)Blocks.size(), 1, [this](unsigned Begin, unsigned End, unsigned /*Worker*/)
+		{
+			for (unsigned i = Begin; i < End; i++)
+			{
+				BodyBlock* Block = Blocks[i];
+				if (Block->Type != Body::bt_Dynamic)
+					continue;
+
+				for (unsigned Slot = 0; Slot < Block->Used; Slot++)
+				{
+					Body& body = Block->Bodies[Slot];
+					if (body.GetAwake() && body.GetCanSleep() && body.GetMotion() < SleepEpsilon && !Islands.Contains(&body))
+						body.SetAwake(false);
+				}
+			}
+		});
 	}
 
 	void World::Step(float dt)
 	{
-		CData.Reset(MaxContacts);
 		CData.Friction = 0.5f;
 		CData.Restitution = 0.5f;
+		CData.Tolerance = 0.001f;
+
+		//All the scratch memory of the last Step goes back at once, and the
+		//scratch arrays start over empty in the arena.
+		Arena.Reset();
+		AttachToArena(PotentialContacts, &Arena);
+		Islands.SetArena(&Arena);
+		for (unsigned i = 0; i < Resolvers.size(); i++)
+			Resolvers[i].SetArena(&Arena);
+
+		if (KeepSnapshots)
+			CaptureTransforms(false);
+
+		//Every block integrates its bodies straight out of its BodyStore, a
+		//few at a time, and only then updates their matrices one by one.
+		Jobs.ParallelFor((unsigned)Blocks.size(), 1, [this, dt](unsigned Begin, unsigned End, unsigned /*Worker*/)
+		{
+			for (unsigned i = Begin; i < End; i++)
+			{
+				BodyBlock* Block = Blocks[i];
+				if (Block->Type == Body::bt_Static)
+					continue;
+
+				//Kinematic bodies are awake while they move, so they wake up what
+				//they run into but leave the bodies resting on them asleep otherwise.
+				//With no mass, no gravity and no damping, Integrate just moves them.
+				if (Block->Type == Body::bt_Kinematic)
+				{
+					for (unsigned Slot = 0; Slot < Block->Used; Slot++)
+					{
+						Body& body = Block->Bodies[Slot];
+						Vec3 Velocity = body.GetVelocity();
+						Vec3 Rotation = body.GetRotation();
+						body.SetAwake(DotProduct(Velocity, Velocity) + DotProduct(Rotation, Rotation) > 0.0f);
+					}
+				}
+
+				Block->Store.Integrate(dt, 0, Block->Used);
+
+				for (unsigned Slot = 0; Slot < Block->Used; Slot++)
+				{
+					if (Block->Store.WasIntegrated(Slot))
+						Block->Bodies[Slot].CalculateDerivedData();
+				}
+			}
+		});
+
+		BPhase.Update();
+		unsigned PairCount = BPhase.FindPotentialContacts(PotentialContacts);
 
-		Body* ptrStack = Stack;
-		while (ptrStack != nullptr)
+		//Sleeping bodies haven't moved since they fell asleep, so a pair of
+		//them is left out of the narrow phase. A pair with an awake body is
+		//kept, its contacts wake the other one up.
+		unsigned AwakePairs = 0;
+		for (unsigned i = 0; i < PairCount; i++)
 		{
-			(ptrStack)->Integrate(dt);
-			ptrStack = ptrStack->m_pNext;
+			const PotentialContact<Body>& Pair = PotentialContacts[i];
+			if (Pair.Object[0]->GetAwake() || Pair.Object[1]->GetAwake())
+				PotentialContacts[AwakePairs++] = Pair;
 		}
 
-		ptrStack = Stack;
-		while (ptrStack != nullptr)
+		Stats.SleepingPairs = PairCount - AwakePairs;
+		PairCount = AwakePairs;
+		PotentialContacts.resize(PairCount);
+
+		Stats.FilteredPairs = 0;
+		if (Filter && PairCount > 0)
 		{
-			for (Body* i = ptrStack->m_pNext; i != nullptr; )
+			bool* Keep = static_cast<bool*>(Arena.Allocate(PairCount * sizeof(bool), alignof(bool)));
+			std::fill(Keep, Keep + PairCount, true);
+			Filter(PotentialContacts.data(), PairCount, Keep);
+
+			unsigned Kept = 0;
+			for (unsigned i = 0; i < PairCount; i++)
 			{
-				CrunchMath::CollisionDetector::Collision(*ptrStack, *i, &CData);
-				i = i->m_pNext;
-		    }
-			ptrStack = ptrStack->m_pNext;
+				if (Keep[i])
+					PotentialContacts[Kept++] = PotentialContacts[i];
+			}
+
+			Stats.FilteredPairs = PairCount - Kept;
+			PairCount = Kept;
+			PotentialContacts.resize(PairCount);
 		}
 
-		Resolver.ResolveContacts(Contacts, CData.ContactCount, dt);
+		Contacts.clear();
+		Stats.DroppedContacts = 0;
+		if (PairCount > 0)
+			FindContacts(PairCount);
+
+		unsigned ContactCount = (unsigned)Contacts.size();
+		Stats.PairCount = PairCount;
+		Stats.ContactCount = ContactCount;
+
+		if (WarmStarting)
+			Cache.LoadImpulses(Contacts.data(), ContactCount);
+
+		//Contacts of different islands can't affect each other, the Resolver
+		//is much faster on a few small sets than on one big one, and the
+		//islands can be resolved at the same time.
+		unsigned IslandCount = Islands.Build(Contacts.data(), ContactCount);
+		Stats.IslandCount = IslandCount;
+		//The worst-first Resolver spends an iteration on each contact it fixes, so the
+		//islands share the budget by their number of contacts, as they did when one
+		//call resolved them all. A sequential impulse iteration is a sweep over the
+		//island, each island gets all of those.
+		bool ShareBudget = Resolvers[0].GetSolverType() == ContactResolver::st_WorstFirst;
+		Jobs.ParallelFor(IslandCount, 1, [this, dt, ShareBudget, ContactCount](unsigned Begin, unsigned End, unsigned Worker)
+		{
+			for (unsigned i = Begin; i < End; i++)
+			{
+				const IslandBuilder::Island& island = Islands.GetIsland(i);
+				if (ShareBudget)
+					Resolvers[Worker].SetIterations(IslandShare(PositionIterations, island.ContactCount, ContactCount),
+						IslandShare(VelocityIterations, island.ContactCount, ContactCount));
+				Resolvers[Worker].ResolveContacts(Contacts.data() + island.FirstContact, island.ContactCount, dt);
+			}
+		});
+
+		if (WarmStarting)
+			Cache.StoreImpulses(Contacts.data(), ContactCount);
+
+		if (Sleeping)
+			UpdateSleep();
+
+		if (KeepSnapshots)
+			CaptureTransforms(true);
+
+		Stats.FrameBytes = Arena.GetUsed();
+		Stats.FrameHighWater = Arena.GetHighWater();
+		Stats.FrameHeapBlocks = Arena.GetHeapBlocks();
 	}
 }
\ No newline at end of file
@@ -1,58 +1,288 @@
 #pragma once
-#include "Collisions.h"
+#include <vector>
+#include <mutex>
+#include <functional>
+#include "BodyStore.h"
+#include "BroadPhase.h"
+#include "ContactCache.h"
+#include "FrameArena.h"
+#include "IslandBuilder.h"
+#include "JobSystem.h"
+#include "ShapePool.h"
 
 namespace CrunchMath {
 
+	/**
+	 * Refers to a body of a World. Unlike a Body pointer, a handle can be
+	 * checked: once the body is destroyed World::GetBody returns nullptr
+	 * for it, even after its slot went to a new body.
+	 */
+	struct BodyHandle
+	{
+		unsigned Index = 0xffffffff;
+		unsigned Generation = 0;
+
+		bool operator==(const BodyHandle& other) const { return Index == other.Index && Generation == other.Generation; }
+		bool operator!=(const BodyHandle& other) const { return !(*this == other); }
+	};
+
 	class World
 	{
 	public:
-		World(Vec3 gravity);
-		~World();
+		/**
+		 * Looks over the pairs of a Step before the narrow phase, all in one
+		 * call. Keep has an entry per pair, all true, clearing one drops the
+		 * pair. Only pairs the CollisionFilters let through are passed.
+		 */
+		typedef std::function<void(const PotentialContact<Body>* Pairs, unsigned PairCount, bool* Keep)> PairFilter;
 
-		bool Empty()
+		/** What happened on the last Step. */
+		struct StepStats
 		{
-			for (int i = 0; i < MaxNumberOfBodies; i++)
-			{
-				if (FreeStack[i] == false)
-					return false;
-			}
+			/** Holds the number of pairs handed to the narrow phase. */
+			unsigned PairCount = 0;
+
+			/** Holds the number of pairs left out because both bodies were asleep. */
+			unsigned SleepingPairs = 0;
+
+			/** Holds the number of pairs dropped by the PairFilter. */
+			unsigned FilteredPairs = 0;
 
-			return true;
-		}
+			/** Holds the number of Contacts resolved. */
+			unsigned ContactCount = 0;
 
-		Body* CreateBody(cmShape* primitive);
+			/** Holds the number of Contacts over the limit set by SetMaxContacts, left unresolved. */
+			unsigned DroppedContacts = 0;
+
+			/** Holds DroppedContacts summed over every Step so far. */
+			unsigned long long TotalDroppedContacts = 0;
+
+			unsigned IslandCount = 0;
+
+			/** Holds the bytes of scratch memory the Step took from the frame arena. */
+			size_t FrameBytes = 0;
+
+			/** Holds the most bytes of scratch memory a Step took so far. */
+			size_t FrameHighWater = 0;
+
+			/** Holds the number of blocks the frame arena took from the heap, zero once Steps settle. */
+			unsigned FrameHeapBlocks = 0;
+		};
+
+		World(Vec3 gravity);
+		~World();
+		//Bodies are owned by their World, which can't be copied.
+		World(const World&) = delete;
+		World& operator=(const World&) = delete;
+
+		bool Empty() const { return LiveBodies.empty(); }
+
+		//The shape is only read, bodies of equal shapes share one copy kept by the World.
+		//Static and kinematic bodies are kept apart from the dynamic ones, are never paired with
+		//each other, and cost nothing per Step while they don't move (see Body::BodyType).
+		Body* CreateBody(const cmShape* primitive, Body::BodyType type = Body::bt_Dynamic);
+		//Takes the body out of the World and frees its slot for the next CreateBody.
+		//Pointers to the body must not be used anymore, handles to it turn stale.
+		void DestroyBody(Body* body);
+		void DestroyBody(BodyHandle handle);
+		BodyHandle GetHandle(const Body* body) const;
+		//Returns the body the handle refers to, or nullptr if it has been destroyed.
+		Body* GetBody(BodyHandle handle) const;
+		//Brings the World up to date with a static body moved after the first Step it was in.
+		void UpdateStaticBody(Body* body);
+		//Returns every live body, packed together in no particular order.
+		const std::vector<Body*>& GetBodies() const { return LiveBodies; }
+		//Sets how many Position and Velocity iterations the Resolver may use in a Step. The worst-first
+		//Resolver shares them out over the islands of touching bodies by their number of contacts.
 		void SetIterations(uint32_t Position, uint32_t Velocity);
+		//Selects how the World finds the pairs of bodies to test for collision, bp_DynamicTree by default.
+		void SetBroadPhase(BroadPhase::Type type);
+		//Sets the grid cell size used by BroadPhase::bp_SpatialHash, about the size of the typical body works best.
+		void SetBroadPhaseCellSize(float size);
+		//Turns carrying contact impulses over from one Step to the next on or off, on by default.
+		void SetWarmStarting(bool enabled);
+		//Turns putting quiet bodies to sleep on or off, on by default. Bodies touching each other
+		//only sleep together, once all of them have moved less than SleepEpsilon for a while.
+		void SetSleeping(bool enabled);
+		//Selects how the contacts are resolved, ContactResolver::st_WorstFirst by default.
+		void SetSolver(ContactResolver::SolverType type);
+		//Sets how many threads work on a Step, the calling thread included. One by default.
+		//The results are the same whatever the number of threads.
+		void SetThreadCount(unsigned count);
+		//Sets the most Contacts a Step resolves, the rest are counted in StepStats::DroppedContacts.
+		//Zero, the default, lets the contact buffer grow as far as needed.
+		void SetMaxContacts(unsigned count);
+		//Sets the filter every Step passes its pairs through, none if empty (the default).
+		void SetPairFilter(PairFilter filter);
+		//Makes room for the given number of Contacts up front, so Steps don't have to grow the buffer.
+		void ReserveContacts(unsigned count);
+		//Sets the most bytes of scratch memory kept from one Step to the next, no limit if zero (the default).
+		//Steps needing more still get it, but take the rest from the heap.
+		void SetFrameArenaLimit(size_t bytes);
+		const StepStats& GetStepStats() const { return Stats; }
+		//Turns keeping the poses of the bodies from the start and the end of every Step on or off, off by
+		//default. InterpolateTransforms draws on them.
+		void SetTransformSnapshots(bool enabled);
+		//Fills Models with a model matrix per live body, scaled as Body::GetModelMatrix scales it, Alpha of the
+		//way from the pose of the body at the start of the last Step (0) to its pose at the end (1). Handles, if
+		//given, gets the body of each matrix. Empty until the first Step with snapshots on. Safe to call from
+		//another thread while Step runs.
+		void InterpolateTransforms(float Alpha, std::vector<Mat4x4>& Models, std::vector<BodyHandle>* Handles = nullptr) const;
+		//As above, but packs the matrices tightly, 16 column major floats per body with nothing in between,
+		//so Models can go straight into a glBufferData or glUniformMatrix4fv upload of all the bodies at once.
+		void InterpolateTransforms(float Alpha, std::vector<float>& Models, std::vector<BodyHandle>* Handles = nullptr) const;
 		void Step(float dt);
 	private:
-		//Constructor for children world blocks/nodes
-		World(Vec3 gravity, bool parent);
-
-		World* m_pNext;
-		bool Parent;
-
-		//max number of body handled...if you a user exceeds this limit.
-		//a child world is created in form of a linked list connecting with its parents.
-		//this is done so to reduce memory fragmentation in creating and deleting rigid bodies.
-		//since rigid bodies are always allocated on heap. so we just prepare a block of memory
-		//for set of rigid bodies. you know what i mean...:-)
-		const static unsigned int MaxNumberOfBodies = 100;
-
-		Body Stack[MaxNumberOfBodies];
-		bool FreeStack[MaxNumberOfBodies];
-		unsigned int Index = 0;
-		unsigned int Size = MaxNumberOfBodies;
+		/**
+		 * A fixed block of bodies and the BodyStore they are views onto.
+		 * Blocks are never moved or freed before the World goes, so Body
+		 * pointers stay valid however many bodies are created. All bodies
+		 * of a block are of the same type, so a Step can pass over the
+		 * static blocks as a whole.
+		 */
+		struct BodyBlock
+		{
+			CrunchMath::BodyStore Store;
+			Body Bodies[BodyStore::Capacity];
+
+			Body::BodyType Type = Body::bt_Dynamic;
+
+			/** Holds the number of slots ever handed out, live or destroyed. */
+			unsigned Used = 0;
+		};
+
+		/**
+		 * What the World knows about a slot. Link is the position of the
+		 * body in LiveBodies while the slot is live, and the next slot of
+		 * the free list once it has been destroyed.
+		 */
+		struct BodySlot
+		{
+			unsigned Generation;
+			unsigned Link;
+		};
+
+		/**
+		 * The poses of the live bodies at the start and at the end of a
+		 * Step, an entry per body in the order of LiveBodies, each array
+		 * contiguous so they can be interpolated in batches.
+		 */
+		struct TransformSnapshot
+		{
+			std::vector<BodyHandle> Handles;
+			std::vector<Vec3> Sizes;
+
+			std::vector<Vec3> PreviousPositions;
+			std::vector<Quaternion> PreviousOrientations;
+
+			std::vector<Vec3> Positions;
+			std::vector<Quaternion> Orientations;
+		};
+
+		const static unsigned NoSlot = 0xffffffff;
+
+		/** Holds the number of Body::BodyTypes. */
+		const static unsigned BodyTypeCount = 3;
+
+		//Returns the body of the given slot.
+		Body* GetSlotBody(unsigned Id) const;
+
+		//Runs the narrow phase over the pairs found by the broad phase, filling Contacts.
+		void FindContacts(unsigned PairCount);
+
+		//Puts the islands whose bodies are all quiet to sleep, and the quiet bodies touching nothing.
+		void UpdateSleep();
+
+		//Records the poses of the live bodies in the back snapshot, as of the start of the Step or its end.
+		void CaptureTransforms(bool End);
+
+		//Writes the interpolated model matrices of the entries of the snapshot, Stride floats apart from
+		//Models on. The caller holds SnapshotLock and has made room for them.
+		void InterpolateSnapshot(const TransformSnapshot& Snapshot, float Alpha, float* Models, size_t Stride) const;
+
+		/** Holds the blocks of bodies, slot Id lives in Blocks[Id / BodyStore::Capacity]. */
+		std::vector<BodyBlock*> Blocks;
+
+		/** Holds a BodySlot for every slot of every block. */
+		std::vector<BodySlot> Slots;
+
+		/** Holds the most recently destroyed slot of each body type, the heads of the free lists. */
+		unsigned FirstFree[BodyTypeCount] = { NoSlot, NoSlot, NoSlot };
+
+		/** Holds the newest block of each body type, new slots are handed out of it until it is full. */
+		unsigned LastBlock[BodyTypeCount] = { NoSlot, NoSlot, NoSlot };
+
+		/** Holds the live bodies, packed. */
+		std::vector<Body*> LiveBodies;
+
+		/** Holds the shapes of the bodies. */
+		CrunchMath::ShapePool Shapes;
+
 		Vec3 Gravity = Vec3(0.0f, 0.0f, 0.0f);
 
-		/** Holds the maximum number of Contacts. */
-		const static unsigned MaxContacts = 5000;
+		/** Holds the most Contacts a Step resolves, no limit if zero. */
+		unsigned MaxContacts = 0;
+
+		/** Holds the Contacts of the last Step, it keeps its capacity from Step to Step. */
+		std::vector<CrunchMath::Contact> Contacts;
+
+		/** Holds what happened on the last Step. */
+		StepStats Stats;
+
+		/** Holds the broad phase, which finds the pairs worth testing for collision. */
+		CrunchMath::BroadPhase BPhase;
 
-		/** Holds the array of Contacts. */
-		CrunchMath::Contact Contacts[MaxContacts];
+		/** Holds the scratch memory of the Step, it is all given back at the start of the next one. */
+		CrunchMath::FrameArena Arena;
 
-		/** Holds the collision data structure for collision detection. */
+		/** Holds the pairs found by the broad phase on the last Step. */
+		FrameVector<PotentialContact<Body>> PotentialContacts;
+
+		/** Holds the Friction, Restitution and Tolerance given to the Contacts. */
 		CrunchMath::CollisionData CData;
 
-		/** Holds the contact Resolver. */
-		CrunchMath::ContactResolver Resolver;
+		/** Holds the iterations given to SetIterations, for the whole Step. */
+		uint32_t PositionIterations = 5000;
+		uint32_t VelocityIterations = 100;
+
+		/** Holds a contact Resolver for each thread, all set up the same. */
+		std::vector<CrunchMath::ContactResolver> Resolvers;
+
+		/** Holds the islands of the last Step, each resolved on its own. */
+		CrunchMath::IslandBuilder Islands;
+
+		/** Holds the impulses of the last Step, used to warm start the Resolver. */
+		CrunchMath::ContactCache Cache;
+
+		/** Holds whether the Resolver is warm started from the Cache. */
+		bool WarmStarting = true;
+
+		/** Holds whether quiet bodies are put to sleep. */
+		bool Sleeping = true;
+
+		/** Holds the filter the pairs of a Step are passed through. */
+		PairFilter Filter;
+
+		/** Holds the threads a Step is shared out over. */
+		CrunchMath::JobSystem Jobs;
+
+		/** Holds the snapshot of the last Step, Snapshots[FrontSnapshot], and the one the next Step fills. */
+		TransformSnapshot Snapshots[2];
+		unsigned FrontSnapshot = 0;
+
+		/** Guards FrontSnapshot, and the front snapshot while it is read. */
+		mutable std::mutex SnapshotLock;
+
+		/** Holds whether the Step keeps TransformSnapshots. */
+		bool KeepSnapshots = false;
+
+		/** Holds the number of pairs in each narrow phase batch. */
+		const static unsigned PairBatchSize = 64;
+
+		/** Holds the Contacts of each batch of pairs, before they are copied into Contacts. In the Arena. */
+		CrunchMath::Contact* PairContacts = nullptr;
+
+		/** Holds the number of Contacts each batch of pairs generated. In the Arena. */
+		unsigned* BatchContactCounts = nullptr;
 	};
 }
\ No newline at end of file
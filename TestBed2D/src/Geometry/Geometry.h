@@ -27,7 +27,13 @@ namespace DebugRenderer {
 			//Note. i'm not stupid for doing this. there is no need to be copying Model matrix generated from the physics library into body.
 			//i'm just trying to show ways it can be used just incase you have a different math library. you can just create your own copy method.
 			//You get the point.
-			Model = body->GetModelMatrix();
+			Render(body->GetModelMatrix());
+		}
+
+		//Draws with the given Model matrix, e.g. one of World::InterpolateTransforms.
+		virtual void Render(const CrunchMath::Mat4x4& model)
+		{
+			Model = model;
 			glUseProgram(ProgramID);
 			glUniformMatrix4fv(glGetUniformLocation(this->ProgramID, "Model"), 1, GL_FALSE, &Model.Matrix[0][0]);
 			glUniform4f(glGetUniformLocation(this->ProgramID, "Color"), Color.x, Color.y, Color.z, Color.a);
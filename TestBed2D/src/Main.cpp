@@ -102,15 +102,18 @@ int main()
     CrunchMath::cmBox groundshape;
     groundshape.Set((Box1.Size.x / 2.0f), (Box1.Size.y / 2.0f), 0.0f);
 
-    CrunchMath::Body* body = gameWorld.CreateBody(&groundshape);
+    CrunchMath::Body* body = gameWorld.CreateBody(&groundshape, CrunchMath::Body::bt_Static);
     body->SetPosition(Box1.Position.x, Box1.Position.y, 0.0f);
     body->SetOrientation(1.0f, 0.0, 0.0f, 0.0f);
-    body->SetAcceleration(CrunchMath::Vec3(0.0f, 0.0f, 0.0f));
     body->CalculateDerivedData();
-    body->SetMass(0.0f);
-    body->SetAwake(false);
     Box1.body = body;
     Boxes.emplace_back(Box1);
+
+    //The boxes are drawn between the last two Steps, from the World's snapshot.
+    gameWorld.SetTransformSnapshots(true);
+    std::vector<CrunchMath::Mat4x4> Models;
+    std::vector<CrunchMath::BodyHandle> Handles;
+    std::vector<int> ModelOfSlot;
    
     float dt = 0.0f;
     float lastFrameTimeStamp = 0.0f;
@@ -136,12 +139,29 @@ int main()
             int State = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT);
             if (State == GLFW_PRESS)
                 Spawn();
-            gameWorld.Step(dt);
-            accumulatedTime -= dt;
+            gameWorld.Step(fr);
+            accumulatedTime -= fr;
+        }
+
+        //The time left over is how far the display is into the next Step.
+        gameWorld.InterpolateTransforms(accumulatedTime / fr, Models, &Handles);
+        ModelOfSlot.assign(ModelOfSlot.size(), -1);
+        for (int i = 0; i < Handles.size(); i++)
+        {
+            if (Handles[i].Index >= ModelOfSlot.size())
+                ModelOfSlot.resize(Handles[i].Index + 1, -1);
+            ModelOfSlot[Handles[i].Index] = i;
         }
 
         for (int a = 0; a < Boxes.size(); a++)
-            Boxes[a].Render();
+        {
+            //Bodies the snapshot doesn't have yet, before the first Step, are drawn where they are.
+            unsigned Slot = gameWorld.GetHandle(Boxes[a].body).Index;
+            if (Slot < ModelOfSlot.size() && ModelOfSlot[Slot] >= 0)
+                Boxes[a].Render(Models[ModelOfSlot[Slot]]);
+            else
+                Boxes[a].Render();
+        }
 
         glfwSwapBuffers(window);
         glfwPollEvents();
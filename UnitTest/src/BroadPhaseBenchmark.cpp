@@ -0,0 +1,106 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+#include "CrunchMath.h"
+
+//Steps the same grid of jittering boxes with each broad phase and prints the cost of a
+//step and how many pairs it handed to the narrow phase.
+//Usage: BroadPhaseBenchmark [steps, 60 by default] [boxes, 2000 by default]
+
+struct Result
+{
+	double MillisecondsPerStep;
+	unsigned PairCount;
+};
+
+static Result RunBroadPhase(CrunchMath::BroadPhase::Type type, int steps, int count)
+{
+	const float HalfSize = 0.025f;
+	const float Spacing = 0.055f;
+	const float Jitter = 0.0025f;
+	const int Row = 20;
+
+	CrunchMath::World world(CrunchMath::Vec3(0.0f, 0.0f, 0.0f));
+	world.SetBroadPhase(type);
+	world.SetBroadPhaseCellSize(4.0f * HalfSize);
+	//Nothing rests on anything, but the boxes still must not fall asleep between the jitters.
+	world.SetSleeping(false);
+
+	//The boxes sit a few millimetres apart, in layers of Row x Row, and are shaken a
+	//little every step, so each broad phase has to keep up with bodies that all move.
+	std::vector<CrunchMath::Body*> bodies;
+	std::vector<CrunchMath::Vec3> positions;
+	for (int i = 0; i < count; i++)
+	{
+		CrunchMath::cmBox box;
+		box.Set(HalfSize, HalfSize, HalfSize);
+
+		CrunchMath::Body* body = world.CreateBody(&box);
+		CrunchMath::Vec3 position((i % Row) * Spacing, ((i / Row) % Row) * Spacing, (i / (Row * Row)) * Spacing);
+		body->SetPosition(position);
+		body->SetMass(1.0f);
+		body->SetBlockInertiaTensor(CrunchMath::Vec3(HalfSize, HalfSize, HalfSize), 1.0f);
+		body->SetAwake(true);
+		body->CalculateDerivedData();
+
+		bodies.push_back(body);
+		positions.push_back(position);
+	}
+
+	//Every broad phase gets the same jitter.
+	std::srand(5);
+
+	Result result;
+	result.PairCount = 0;
+	double total = 0.0;
+	for (int s = 0; s < steps; s++)
+	{
+		for (unsigned i = 0; i < bodies.size(); i++)
+		{
+			positions[i].x += Jitter * ((std::rand() % 201) - 100) / 100.0f;
+			positions[i].y += Jitter * ((std::rand() % 201) - 100) / 100.0f;
+			positions[i].z += Jitter * ((std::rand() % 201) - 100) / 100.0f;
+			bodies[i]->SetPosition(positions[i]);
+			bodies[i]->SetVelocity(0.0f, 0.0f, 0.0f);
+			bodies[i]->CalculateDerivedData();
+		}
+
+		std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		world.Step(1.0f / 60.0f);
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+		total += std::chrono::duration<double, std::milli>(end - begin).count();
+		result.PairCount = world.GetStepStats().PairCount;
+	}
+
+	result.MillisecondsPerStep = total / steps;
+	return result;
+}
+
+int main(int argc, char** argv)
+{
+	int steps = (argc > 1) ? std::atoi(argv[1]) : 60;
+	if (steps <= 0)
+		steps = 60;
+
+	int count = (argc > 2) ? std::atoi(argv[2]) : 2000;
+	if (count <= 0)
+		count = 2000;
+
+	const CrunchMath::BroadPhase::Type types[] = { CrunchMath::BroadPhase::bp_BruteForce, CrunchMath::BroadPhase::bp_SweepAndPrune,
+		CrunchMath::BroadPhase::bp_DynamicTree, CrunchMath::BroadPhase::bp_SpatialHash };
+	const char* names[] = { "brute force", "sweep and prune", "dynamic tree", "spatial hash" };
+
+	std::cout << count << " boxes of 5 cm on a grid, jittering by up to " << 2.5f << " mm a step, " << steps << " steps." << std::endl;
+	std::cout << "Pairs is the number of pairs handed to the narrow phase on the last step." << std::endl << std::endl;
+	std::cout << std::left << std::setw(20) << "broad phase" << std::setw(14) << "ms/step" << "pairs" << std::endl;
+
+	for (unsigned i = 0; i < 4; i++)
+	{
+		Result result = RunBroadPhase(types[i], steps, count);
+		std::cout << std::left << std::setw(20) << names[i] << std::setw(14) << std::fixed << std::setprecision(3)
+			<< result.MillisecondsPerStep << result.PairCount << std::endl;
+	}
+}
@@ -0,0 +1,121 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+#include "CrunchMath.h"
+
+//Times the math kernels the physics spends most of its time in. Built twice, as
+//SimdBenchmark on the SIMD backend and as SimdBenchmarkScalar with CM_SIMD_SCALAR,
+//so the two can be compared on the same machine.
+//Usage: SimdBenchmark [repeats, 500 by default]
+
+static double NanosecondsSince(std::chrono::steady_clock::time_point begin, double operations)
+{
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(end - begin).count() / operations;
+}
+
+//Integrates a set of spinning, moving bodies, the same work a Step does for each awake body.
+static double TimeIntegrate(int repeats)
+{
+	const int Count = 1024;
+
+	CrunchMath::World world(CrunchMath::Vec3(0.0f, -9.8f, 0.0f));
+	std::vector<CrunchMath::Body*> bodies;
+	for (int i = 0; i < Count; i++)
+	{
+		CrunchMath::cmBox box;
+		box.Set(0.1f, 0.1f, 0.1f);
+
+		CrunchMath::Body* body = world.CreateBody(&box);
+		body->SetPosition((float)i, 0.0f, 0.0f);
+		body->SetOrientation(1.0f, 0.1f, 0.2f, 0.3f);
+		body->SetVelocity(1.0f, 2.0f, 3.0f);
+		body->SetRotation(0.1f, 0.2f, 0.3f);
+		body->SetMass(1.0f);
+		body->SetBlockInertiaTensor(CrunchMath::Vec3(0.1f, 0.1f, 0.1f), 1.0f);
+		body->SetAwake(true);
+		body->CalculateDerivedData();
+		bodies.push_back(body);
+	}
+
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	for (int r = 0; r < repeats; r++)
+	{
+		for (CrunchMath::Body* body : bodies)
+			body->Integrate(1.0f / 600.0f);
+	}
+
+	return NanosecondsSince(begin, (double)repeats * Count);
+}
+
+//Builds a contact normal and moves a relative position along it, as the contact
+//generation and the Resolver do for every contact.
+static double TimeContactMath(int repeats, float& Checksum)
+{
+	const int Count = 4096;
+
+	std::vector<CrunchMath::Vec3> one(Count), two(Count);
+	for (int i = 0; i < Count; i++)
+	{
+		one[i] = CrunchMath::Vec3(i * 0.1f + 1.0f, i * 0.2f - 3.0f, 1.5f);
+		two[i] = CrunchMath::Vec3(0.3f, i * 0.05f, 2.0f - i * 0.01f);
+	}
+
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	for (int r = 0; r < repeats * 4; r++)
+	{
+		for (int i = 0; i < Count; i++)
+		{
+			CrunchMath::Vec3 normal = CrunchMath::CrossProduct(one[i], two[i]);
+			normal.Normalize();
+			CrunchMath::Vec3 relative = one[i] - two[i] * 0.5f;
+			CrunchMath::Vec3 moved = relative + normal * CrunchMath::DotProduct(relative, normal);
+			Checksum += CrunchMath::DotProduct(moved, normal);
+		}
+	}
+
+	return NanosecondsSince(begin, (double)repeats * 4 * Count);
+}
+
+//Chains quaternion products, as integrating an orientation over many steps does.
+static double TimeQuaternion(int repeats, float& Checksum)
+{
+	const int Count = 16000;
+
+	CrunchMath::Quaternion orientation(1.0f, 0.1f, 0.2f, 0.3f);
+	CrunchMath::Quaternion step(0.9f, -0.1f, 0.3f, 0.2f);
+
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	for (int r = 0; r < repeats * Count; r++)
+	{
+		orientation = orientation * step;
+		orientation.Normalize();
+	}
+
+	Checksum += orientation.w;
+	return NanosecondsSince(begin, (double)repeats * Count);
+}
+
+int main(int argc, char** argv)
+{
+	int repeats = (argc > 1) ? std::atoi(argv[1]) : 500;
+	if (repeats <= 0)
+		repeats = 500;
+
+#if defined(CM_SIMD_SSE)
+	std::cout << "Math backend: SSE" << std::endl << std::endl;
+#else
+	std::cout << "Math backend: scalar" << std::endl << std::endl;
+#endif
+
+	//Printed, so the compiler can't drop the work.
+	float checksum = 0.0f;
+
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << std::left << std::setw(30) << "Body::Integrate" << TimeIntegrate(repeats) << " ns/body" << std::endl;
+	std::cout << std::left << std::setw(30) << "contact math" << TimeContactMath(repeats, checksum) << " ns/op" << std::endl;
+	std::cout << std::left << std::setw(30) << "quaternion multiply" << TimeQuaternion(repeats, checksum) << " ns/op" << std::endl;
+	std::cout << std::endl << "checksum " << checksum << std::endl;
+}
@@ -0,0 +1,108 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include "CrunchMath.h"
+
+//Steps the same stacks of boxes with each contact solver and prints the cost of a
+//frame and how far the boxes drifted from where they started.
+//Usage: SolverBenchmark [steps, 600 by default]
+
+struct Scene
+{
+	int Columns;
+	int Height;
+};
+
+struct Result
+{
+	double MillisecondsPerStep;
+	float Drift;
+};
+
+static Result RunScene(const Scene& scene, CrunchMath::ContactResolver::SolverType solver, int steps)
+{
+	const float HalfSize = 0.025f;
+
+	CrunchMath::World world(CrunchMath::Vec3(0.0f, -9.8f, 0.0f));
+	world.SetIterations(5000, 100);
+	world.SetWarmStarting(true);
+	world.SetSolver(solver);
+	//Resting stacks would go to sleep, and then there would be nothing left to time.
+	world.SetSleeping(false);
+
+	CrunchMath::cmBox ground;
+	ground.Set(50.0f, 0.25f, 50.0f);
+	CrunchMath::Body* floor = world.CreateBody(&ground, CrunchMath::Body::bt_Static);
+	floor->SetPosition(0.0f, -0.25f, 0.0f);
+	floor->CalculateDerivedData();
+
+	//The stacks start out resting on each other, nothing has to fall into place.
+	std::vector<CrunchMath::Body*> bodies;
+	std::vector<CrunchMath::Vec3> start;
+	for (int c = 0; c < scene.Columns; c++)
+	{
+		for (int i = 0; i < scene.Height; i++)
+		{
+			CrunchMath::cmBox box;
+			box.Set(HalfSize, HalfSize, HalfSize);
+
+			CrunchMath::Body* body = world.CreateBody(&box);
+			CrunchMath::Vec3 position(c * 4.0f * HalfSize, HalfSize + i * 2.0f * HalfSize, 0.0f);
+			body->SetPosition(position);
+			body->SetDamping(0.9f, 0.9f);
+			body->SetMass(1.0f);
+			body->SetBlockInertiaTensor(CrunchMath::Vec3(HalfSize, HalfSize, HalfSize), 1.0f);
+			body->SetAwake(true);
+			body->CalculateDerivedData();
+
+			bodies.push_back(body);
+			start.push_back(position);
+		}
+	}
+
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	for (int s = 0; s < steps; s++)
+		world.Step(1.0f / 60.0f);
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+	Result result;
+	result.MillisecondsPerStep = std::chrono::duration<double, std::milli>(end - begin).count() / steps;
+	result.Drift = 0.0f;
+	for (unsigned i = 0; i < bodies.size(); i++)
+	{
+		CrunchMath::Vec3 offset = bodies[i]->GetPosition() - start[i];
+		result.Drift = std::fmax(result.Drift, std::sqrt(CrunchMath::DotProduct(offset, offset)));
+	}
+
+	return result;
+}
+
+int main(int argc, char** argv)
+{
+	int steps = (argc > 1) ? std::atoi(argv[1]) : 600;
+	if (steps <= 0)
+		steps = 600;
+
+	const Scene scenes[] = { { 1, 5 }, { 1, 10 }, { 4, 5 }, { 10, 3 } };
+
+	std::cout << "Boxes of 5 cm, 60 Hz, " << steps << " steps, 100 velocity iterations, warm starting on." << std::endl;
+	std::cout << "Drift is the largest distance a box ended up from where it started, in metres." << std::endl << std::endl;
+	std::cout << std::left << std::setw(16) << "scene" << std::setw(28) << "worst-first" << "sequential impulse" << std::endl;
+
+	for (const Scene& scene : scenes)
+	{
+		Result worst = RunScene(scene, CrunchMath::ContactResolver::st_WorstFirst, steps);
+		Result sequential = RunScene(scene, CrunchMath::ContactResolver::st_SequentialImpulse, steps);
+
+		std::ostringstream name, left, right;
+		name << scene.Columns << " x " << scene.Height << " stack" << (scene.Columns > 1 ? "s" : "");
+		left << std::fixed << std::setprecision(2) << worst.MillisecondsPerStep << " ms, drift " << std::setprecision(3) << worst.Drift;
+		right << std::fixed << std::setprecision(2) << sequential.MillisecondsPerStep << " ms, drift " << std::setprecision(3) << sequential.Drift;
+
+		std::cout << std::left << std::setw(16) << name.str() << std::setw(28) << left.str() << right.str() << std::endl;
+	}
+}